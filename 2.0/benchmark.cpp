@@ -0,0 +1,399 @@
+//
+//  benchmark.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "grid.h"
+#include "pool.h"
+#include "tiles.h"
+#include "decay.h"
+#include "kernel.h"
+#include "screen.h"
+#include "sparse.h"
+#include "hashlife.h"
+#include "patterns.h"
+#include "snapshot.h"
+#include "generator.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <benchmark/benchmark.h>
+
+// board sizes are given as width and height, densities as percents of living cells,
+// bytes processed count the words read and written, not the ones in cache lines around them
+namespace
+{
+	// same random world for the same arguments, so runs can be compared
+	game::grid random_world(uint32_t width, uint32_t height, uint32_t density)
+	{
+		game::grid world {width, height};
+		game::pool workers {std::max(std::thread::hardware_concurrency(), 1u)};
+		game::fill(world, width * 31ull + height * 17ull + density, density, workers);
+		return world;
+	}
+	
+	int64_t bytes(const game::grid & world)
+	{
+		return static_cast<int64_t>(world.stride()) * world.height() * sizeof(uint64_t);
+	}
+	
+	void sizes(benchmark::internal::Benchmark * b)
+	{
+		for (const auto & [width, height] : std::initializer_list<std::pair<int64_t, int64_t>> {{50, 26}, {256, 256}, {1024, 1024}, {4096, 4096}, {16384, 16384}})
+		{
+			for (int64_t density : {10, 30, 50})
+			{
+				b->Args({width, height, density});
+			}
+		}
+	}
+	
+	// whole torus by the kernel alone
+	void step_kernel(benchmark::State & state)
+	{
+		game::grid src {random_world(state.range(0), state.range(1), state.range(2))};
+		game::grid dst {src.width(), src.height()};
+		const game::kernel kernel {};
+		for (auto _ : state)
+		{
+			kernel.step(src, dst, 0, src.height());
+			std::swap(src, dst);
+			benchmark::DoNotOptimize(src.row(0));
+		}
+		state.SetItemsProcessed(state.iterations() * src.width() * src.height());
+		state.SetBytesProcessed(state.iterations() * bytes(src) * 2);
+	}
+	
+	// kernels made for a rule against the one played through a table, a 1024x1024 torus with 30% alive
+	void step_rule(benchmark::State & state)
+	{
+		// Diamoeba is played through the table
+		const std::array<game::rule, 5> rules {game::conway, game::highlife, game::day_and_night, game::seeds, game::rule {0b111101000, 0b111100000, 2}};
+		const game::rule r {rules.at(state.range(0))};
+		game::grid src {random_world(1024, 1024, 30)};
+		game::grid dst {src.width(), src.height()};
+		const game::kernel kernel {r};
+		for (auto _ : state)
+		{
+			kernel.step(src, dst, 0, src.height());
+			std::swap(src, dst);
+			benchmark::DoNotOptimize(src.row(0));
+		}
+		state.SetLabel(game::rule_name(r));
+		state.SetItemsProcessed(state.iterations() * src.width() * src.height());
+	}
+	
+	// Generations rules: living cells by the kernel, then the dying ones aged in their bit planes,
+	// a 1024x1024 torus with 30% alive; Brian's Brain has 1 plane, Star Wars 2
+	void step_decay(benchmark::State & state)
+	{
+		const game::rule r {state.range(0) == 0 ? game::brians_brain : game::star_wars};
+		game::grid src {random_world(1024, 1024, 30)};
+		game::grid dst {src.width(), src.height()};
+		game::decay dying;
+		dying.resize(src.width(), src.height(), r.states);
+		const game::kernel kernel {r};
+		for (auto _ : state)
+		{
+			kernel.step(src, dst, 0, src.height());
+			benchmark::DoNotOptimize(dying.step(src, dst, 0, src.height()));
+			std::swap(src, dst);
+		}
+		state.SetLabel(game::rule_name(r));
+		state.SetItemsProcessed(state.iterations() * src.width() * src.height());
+	}
+	
+	// random world of the given size and density as the game makes it, on all hardware threads
+	void fill_world(benchmark::State & state)
+	{
+		game::grid world {static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1))};
+		game::pool workers {std::max(std::thread::hardware_concurrency(), 1u)};
+		uint64_t seed {};
+		for (auto _ : state)
+		{
+			game::fill(world, ++seed, static_cast<uint32_t>(state.range(2)), workers);
+			benchmark::DoNotOptimize(world.row(0));
+		}
+		state.SetItemsProcessed(state.iterations() * world.width() * world.height());
+		state.SetBytesProcessed(state.iterations() * bytes(world));
+	}
+	
+	// soups of a search packed side by side, soup_lanes worlds of the given size with 30% alive a step
+	void step_soups(benchmark::State & state)
+	{
+		const uint32_t width {static_cast<uint32_t>(state.range(0))};
+		const uint32_t height {static_cast<uint32_t>(state.range(1))};
+		std::vector<uint64_t> src(static_cast<std::size_t>(height) * game::soup_lanes);
+		std::vector<uint64_t> dst(src.size());
+		const game::grid world {random_world(width, height * game::soup_lanes, 30)};
+		for (uint32_t y {}; y < height; ++y)
+		{
+			for (uint32_t i {}; i < game::soup_lanes; ++i)
+			{
+				src[static_cast<std::size_t>(y) * game::soup_lanes + i] = world.row(i * height + y)[0];
+			}
+		}
+		const game::kernel kernel {};
+		for (auto _ : state)
+		{
+			kernel.step_soups(src.data(), dst.data(), width, height);
+			std::swap(src, dst);
+			benchmark::DoNotOptimize(src.data());
+		}
+		state.SetItemsProcessed(state.iterations() * width * height * game::soup_lanes);
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(src.size() * sizeof(uint64_t)) * 2);
+	}
+	
+	// generation the way the game steps it: ring of worlds, tiles skipping quiet parts and all hardware threads
+	void step_generation(benchmark::State & state)
+	{
+		std::array<game::grid, 4> worlds;
+		worlds[0] = random_world(state.range(0), state.range(1), state.range(2));
+		for (std::size_t i {1}; i < worlds.size(); ++i)
+		{
+			worlds[i].resize(worlds[0].width(), worlds[0].height());
+		}
+		game::tiles tiles;
+		tiles.resize(worlds[0].width(), worlds[0].height(), static_cast<uint32_t>(worlds.size()));
+		game::pool workers {std::max(std::thread::hardware_concurrency(), 1u)};
+		const game::kernel kernel {};
+		std::size_t newest {};
+		for (auto _ : state)
+		{
+			const game::grid & src {worlds[newest]};
+			newest = (newest + 1) % worlds.size();
+			game::grid & dst {worlds[newest]};
+			workers.run([&](uint32_t index)
+			{
+				const uint32_t count {workers.size()};
+				tiles.step(kernel, src, dst, tiles.rows() * index / count, tiles.rows() * (index + 1) / count);
+			});
+			tiles.swap();
+		}
+		state.SetItemsProcessed(state.iterations() * worlds[0].width() * worlds[0].height());
+		state.SetBytesProcessed(state.iterations() * bytes(worlds[0]) * 2);
+	}
+	
+	template <typename T>
+	std::unique_ptr<game::universe> make_universe();
+	
+	template <>
+	std::unique_ptr<game::universe> make_universe<game::hashlife>()
+	{
+		return std::make_unique<game::hashlife>(0, uint64_t {1024} << 20);
+	}
+	
+	template <>
+	std::unique_ptr<game::universe> make_universe<game::sparse>()
+	{
+		return std::make_unique<game::sparse>();
+	}
+	
+	// unbounded engines one generation at a time, started from a preset of the menu
+	template <typename T>
+	void step_universe(benchmark::State & state)
+	{
+		const game::pattern p {game::preset(static_cast<uint32_t>(state.range(0)))};
+		std::unique_ptr<game::universe> universe {make_universe<T>()};
+		for (uint32_t y {}; y < p.cells.height(); ++y)
+		{
+			for (uint32_t x {}; x < p.cells.width(); ++x)
+			{
+				if (p.cells.get(x, y))
+				{
+					universe->set(x, y);
+				}
+			}
+		}
+		for (auto _ : state)
+		{
+			universe->advance();
+		}
+		state.counters["population"] = static_cast<double>(universe->population());
+		state.SetItemsProcessed(state.iterations());
+	}
+	
+	// cells of a pattern written into the world, as read_layout() does
+	void place_pattern(benchmark::State & state)
+	{
+		const game::grid cells {random_world(state.range(0), state.range(1), state.range(2))};
+		game::grid world {cells.width(), cells.height()};
+		for (auto _ : state)
+		{
+			world.clear();
+			game::place(cells, world, 0, 0);
+			benchmark::DoNotOptimize(world.row(0));
+		}
+		state.SetItemsProcessed(state.iterations() * cells.width() * cells.height());
+		state.SetBytesProcessed(state.iterations() * (bytes(cells) + bytes(world)));
+	}
+	
+	void place_preset(benchmark::State & state)
+	{
+		const game::pattern p {game::preset(static_cast<uint32_t>(state.range(0)))};
+		game::grid world {p.cells.width(), p.cells.height()};
+		for (auto _ : state)
+		{
+			world.clear();
+			game::place(p.cells, world, 0, 0);
+			benchmark::DoNotOptimize(world.row(0));
+		}
+		state.SetBytesProcessed(state.iterations() * (bytes(p.cells) + bytes(world)));
+	}
+	
+	// coordinate file as read_file() reads it, kept in memory so the disk is not measured;
+	// the fourth argument is the number of threads parsing it
+	void read_file(benchmark::State & state)
+	{
+		const game::grid world {random_world(state.range(0), state.range(1), state.range(2))};
+		std::string text {std::to_string(world.height()) + ' ' + std::to_string(world.width()) + '\n'};
+		for (uint32_t y {}; y < world.height(); ++y)
+		{
+			for (uint32_t x {}; x < world.width(); ++x)
+			{
+				if (world.get(x, y))
+				{
+					text += std::to_string(y) + ' ' + std::to_string(x) + '\n';
+				}
+			}
+		}
+		game::pool workers {static_cast<uint32_t>(state.range(3))};
+		for (auto _ : state)
+		{
+			game::pattern p {};
+			uint32_t x {};
+			uint32_t y {};
+			uint64_t line {};
+			benchmark::DoNotOptimize(game::read_coordinates(text, p, x, y, line, workers));
+			benchmark::DoNotOptimize(p.cells.row(0));
+		}
+		state.SetItemsProcessed(state.iterations() * world.population());
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+	}
+	
+	// run length encoded file as read_file() reads it, text is made by the exporter
+	void read_rle(benchmark::State & state)
+	{
+		const game::grid world {random_world(state.range(0), state.range(1), state.range(2))};
+		std::ostringstream out;
+		game::write_rle(out, world, {}, "B3/S23");
+		const std::string text {out.str()};
+		for (auto _ : state)
+		{
+			std::istringstream in {text};
+			game::pattern p {};
+			uint32_t x {};
+			uint32_t y {};
+			uint64_t line {};
+			benchmark::DoNotOptimize(game::read_rle(in, p, x, y, line));
+			benchmark::DoNotOptimize(p.cells.row(0));
+		}
+		state.SetItemsProcessed(state.iterations() * world.width() * world.height());
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+	}
+	
+	void write_rle(benchmark::State & state)
+	{
+		const game::grid world {random_world(state.range(0), state.range(1), state.range(2))};
+		int64_t written {};
+		for (auto _ : state)
+		{
+			std::ostringstream out;
+			game::write_rle(out, world, {}, "B3/S23");
+			written += static_cast<int64_t>(out.tellp());
+		}
+		state.SetItemsProcessed(state.iterations() * world.width() * world.height());
+		state.SetBytesProcessed(written);
+	}
+	
+	// snapshot as a checkpoint encodes it, without the disk
+	void write_snapshot(benchmark::State & state)
+	{
+		const game::snapshot s {random_world(state.range(0), state.range(1), state.range(2)), 1, "B3/S23", {}};
+		std::string data;
+		for (auto _ : state)
+		{
+			game::write_snapshot(data, s);
+			benchmark::DoNotOptimize(data.data());
+		}
+		state.counters["ratio"] = static_cast<double>(data.size()) / static_cast<double>(bytes(s.cells));
+		state.SetBytesProcessed(state.iterations() * bytes(s.cells));
+	}
+	
+	void read_snapshot(benchmark::State & state)
+	{
+		std::string data;
+		game::write_snapshot(data, {random_world(state.range(0), state.range(1), state.range(2)), 1, "B3/S23", {}});
+		game::snapshot s {};
+		for (auto _ : state)
+		{
+			benchmark::DoNotOptimize(game::read_snapshot(data, s));
+			benchmark::DoNotOptimize(s.cells.row(0));
+		}
+		state.SetBytesProcessed(state.iterations() * bytes(s.cells));
+	}
+	
+	// text of a whole frame as the render thread composes it, bytes processed are the bytes of output
+	void draw_frame(benchmark::State & state)
+	{
+		const game::grid world {random_world(state.range(0), state.range(1), state.range(2))};
+		game::screen screen;
+		for (auto _ : state)
+		{
+			screen.clear();
+			screen.invalidate();
+			screen.draw(world, {}, {}, game::colour::CYAN, game::colour::BLACK);
+			benchmark::DoNotOptimize(screen.text().data());
+		}
+		state.SetItemsProcessed(state.iterations() * world.width() * world.height());
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(screen.text().size()));
+	}
+	
+	// frames of successive generations, only changed cells are written
+	void draw_changes(benchmark::State & state)
+	{
+		std::array<game::grid, 2> worlds {random_world(state.range(0), state.range(1), state.range(2))};
+		worlds[1].resize(worlds[0].width(), worlds[0].height());
+		game::kernel {}.step(worlds[0], worlds[1], 0, worlds[0].height());
+		game::screen screen;
+		screen.draw(worlds[0], {}, {}, game::colour::CYAN, game::colour::BLACK);
+		int64_t written {};
+		std::size_t next {1};
+		for (auto _ : state)
+		{
+			screen.clear();
+			screen.draw(worlds[next], {}, {}, game::colour::CYAN, game::colour::BLACK);
+			next ^= 1;
+			written += static_cast<int64_t>(screen.text().size());
+		}
+		state.SetItemsProcessed(state.iterations() * worlds[0].width() * worlds[0].height());
+		state.SetBytesProcessed(written);
+	}
+}
+
+BENCHMARK(step_kernel)->Apply(sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(step_rule)->DenseRange(0, 4)->Unit(benchmark::kMicrosecond);
+BENCHMARK(step_decay)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(step_soups)->Args({16, 16})->Args({32, 32})->Args({64, 64})->Unit(benchmark::kNanosecond);
+BENCHMARK(fill_world)->Args({1024, 1024, 30})->Args({16384, 16384, 30})->Args({16384, 16384, 50})->Unit(benchmark::kMillisecond);
+BENCHMARK(step_generation)->Apply(sizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(step_universe<game::hashlife>)->DenseRange(2, 5)->Unit(benchmark::kMicrosecond);
+BENCHMARK(step_universe<game::sparse>)->DenseRange(2, 5)->Unit(benchmark::kMicrosecond);
+BENCHMARK(place_pattern)->Args({50, 26, 30})->Args({1024, 1024, 30})->Args({4096, 4096, 30})->Unit(benchmark::kMicrosecond);
+BENCHMARK(place_preset)->DenseRange(2, 5);
+BENCHMARK(read_file)->Args({50, 26, 30, 1})->Args({1024, 1024, 10, 1})->Args({1024, 1024, 30, 1})->Args({4096, 4096, 30, 1})->Args({4096, 4096, 30, 4})->Unit(benchmark::kMicrosecond);
+BENCHMARK(read_rle)->Args({50, 26, 30})->Args({1024, 1024, 10})->Args({1024, 1024, 30})->Unit(benchmark::kMicrosecond);
+BENCHMARK(write_rle)->Args({50, 26, 30})->Args({1024, 1024, 10})->Args({1024, 1024, 30})->Unit(benchmark::kMicrosecond);
+BENCHMARK(write_snapshot)->Args({1024, 1024, 1})->Args({1024, 1024, 30})->Args({4096, 4096, 30})->Unit(benchmark::kMicrosecond);
+BENCHMARK(read_snapshot)->Args({1024, 1024, 1})->Args({1024, 1024, 30})->Args({4096, 4096, 30})->Unit(benchmark::kMicrosecond);
+BENCHMARK(draw_frame)->Args({50, 26, 30})->Args({200, 100, 30})->Args({1024, 1024, 30})->Unit(benchmark::kMicrosecond);
+BENCHMARK(draw_changes)->Args({50, 26, 30})->Args({200, 100, 30})->Args({1024, 1024, 30})->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
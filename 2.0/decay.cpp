@@ -0,0 +1,106 @@
+//
+//  decay.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "decay.h"
+#include "kernel.h"
+#include <bit>
+
+namespace game
+{
+	decay::decay() : m_states(2),
+	                 m_count()
+	{
+		
+	}
+	
+	void decay::resize(uint32_t width, uint32_t height, uint32_t states)
+	{
+		m_states = states;
+		m_count = static_cast<uint32_t>(std::bit_width(states - 2));
+		for (uint32_t i {}; i < max_planes; ++i)
+		{
+			m_planes[i].resize(i < m_count ? width : 0, i < m_count ? height : 0);
+		}
+	}
+	
+	void decay::clear()
+	{
+		for (uint32_t i {}; i < m_count; ++i)
+		{
+			m_planes[i].clear();
+		}
+	}
+	
+	bool decay::empty() const
+	{
+		for (uint32_t i {}; i < m_count; ++i)
+		{
+			if (!m_planes[i].empty())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	uint32_t decay::get(uint32_t x, uint32_t y) const
+	{
+		uint32_t age {};
+		for (uint32_t i {}; i < m_count; ++i)
+		{
+			age |= static_cast<uint32_t>(m_planes[i].get(x, y)) << i;
+		}
+		return age == 0 ? 0 : age + 1;
+	}
+	
+	void decay::set(uint32_t x, uint32_t y, uint32_t state)
+	{
+		const uint32_t age {state < 2 ? 0 : state - 1};
+		for (uint32_t i {}; i < m_count; ++i)
+		{
+			m_planes[i].set(x, y, (age >> i) & 1);
+		}
+	}
+	
+	uint64_t decay::step(const grid & before, grid & after, uint32_t first, uint32_t last)
+	{
+		const uint32_t stride {after.stride()};
+		dying_row row {};
+		row.count = m_count;
+		// ages go from 1 to states - 2, a cell reaching states - 1 is dead
+		row.expiry = (m_states - 1) & ((1u << m_count) - 1);
+		row.size = static_cast<uint64_t>(stride) * after.height();
+		uint64_t hash {};
+		for (uint32_t y {first}; y < last; ++y)
+		{
+			row.before = before.row(y);
+			row.after = after.row(y);
+			for (uint32_t i {}; i < m_count; ++i)
+			{
+				row.planes[i] = m_planes[i].row(y);
+			}
+			row.index = static_cast<uint64_t>(y) * stride;
+			hash ^= fade(row, 0, stride);
+		}
+		return hash;
+	}
+	
+	uint64_t decay::hash() const
+	{
+		uint64_t h {};
+		for (uint32_t i {}; i < m_count; ++i)
+		{
+			const grid & plane {m_planes[i]};
+			const uint64_t size {static_cast<uint64_t>(plane.stride()) * plane.height()};
+			for (uint64_t w {}; w < size; ++w)
+			{
+				h ^= word_hash((i + 1) * size + w, plane.row(0)[w]);
+			}
+		}
+		return h;
+	}
+}
@@ -0,0 +1,47 @@
+//
+//  decay.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include <array>
+#include <cstdint>
+
+namespace game
+{
+	// dying cells of a world played by a Generations rule, next to the grid of its living cells:
+	// the age of a dying cell, its state - 1, is kept in binary over as many bit planes as it needs,
+	// 1 plane for 3 states up to 3 planes for 9, so a cell never takes more than 4 bits;
+	// worlds of life-like rules have no planes at all
+	class decay
+	{
+	public:
+		static constexpr uint32_t max_planes {3};
+		decay();
+		void resize(uint32_t width, uint32_t height, uint32_t states);
+		void clear();
+		uint32_t states() const { return m_states; }
+		uint32_t planes() const { return m_count; }
+		// no cell is dying
+		bool empty() const;
+		grid & plane(uint32_t i) { return m_planes[i]; }
+		const grid & plane(uint32_t i) const { return m_planes[i]; }
+		// state from 2 to states - 1 of a dying cell, 0 for living and dead cells
+		uint32_t get(uint32_t x, uint32_t y) const;
+		void set(uint32_t x, uint32_t y, uint32_t state);
+		// moves rows [first, last) on by a generation along with the living cells, before is the generation before
+		// and after the next one as the life-like kernel left it, which cells still dying are taken out of;
+		// returns how the hash of the planes changes, see game::fade()
+		uint64_t step(const grid & before, grid & after, uint32_t first, uint32_t last);
+		// XOR of the hashes of all the plane words, keyed the way step() does
+		uint64_t hash() const;
+		friend bool operator == (const decay & lhs, const decay & rhs) = default;
+	private:
+		uint32_t m_states;
+		uint32_t m_count;												// planes in use
+		std::array<grid, max_planes> m_planes;
+	};
+}
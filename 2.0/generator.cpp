@@ -0,0 +1,84 @@
+//
+//  generator.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "generator.h"
+#include <bit>
+
+namespace game
+{
+	generator::generator(uint64_t seed, uint64_t stream)
+	{
+		// consecutive outputs of splitmix64, so the state is never all zeros
+		const uint64_t base {seed ^ mix(stream)};
+		for (uint64_t i {}; i < 4; ++i)
+		{
+			m_state[i] = mix(base + i * 0x9e3779b97f4a7c15);
+		}
+	}
+	
+	uint64_t generator::operator () ()
+	{
+		const uint64_t result {std::rotl(m_state[1] * 5, 7) * 9};
+		const uint64_t t {m_state[1] << 17};
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = std::rotl(m_state[3], 45);
+		return result;
+	}
+	
+	uint32_t generator::below(uint32_t count)
+	{
+		// upper half of the product of a 32-bit random number and the count, no division
+		return static_cast<uint32_t>(((*this)() >> 32) * count >> 32);
+	}
+	
+	uint64_t generator::cells(uint32_t density)
+	{
+		// chance rounded to n/256: going through the bits of n from the lowest set one up, OR with a random word
+		// for a one and AND for a zero halves the chance of a cell being clear or alive, which builds n/256 bit by bit,
+		// so a word takes at most 8 random numbers and 50% takes one
+		if (density >= 100)
+		{
+			return ~uint64_t {};
+		}
+		const uint32_t chance {(density * 256 + 50) / 100};
+		if (chance == 0)
+		{
+			return 0;
+		}
+		uint64_t word {(*this)()};
+		for (uint32_t bit {static_cast<uint32_t>(std::countr_zero(chance)) + 1}; bit < 8; ++bit)
+		{
+			word = (chance >> bit) & 1 ? word | (*this)() : word & (*this)();
+		}
+		return word;
+	}
+	
+	void fill(grid & world, uint64_t seed, uint32_t density, pool & workers)
+	{
+		const uint32_t height {world.height()};
+		const uint32_t stride {world.stride()};
+		const uint64_t last {world.width() % 64 == 0 ? ~uint64_t {} : (uint64_t {1} << world.width() % 64) - 1};
+		workers.run([&](uint32_t index)
+		{
+			const uint32_t count {workers.size()};
+			for (uint32_t y {height * index / count}; y < height * (index + 1) / count; ++y)
+			{
+				generator random {seed, y};
+				uint64_t * row {world.row(y)};
+				for (uint32_t i {}; i < stride; ++i)
+				{
+					row[i] = random.cells(density);
+				}
+				row[stride - 1] &= last;
+			}
+		});
+	}
+}
@@ -0,0 +1,42 @@
+//
+//  generator.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include "pool.h"
+#include <cstdint>
+
+namespace game
+{
+	// splitmix64, spreads a seed over all bits, so close seeds give unrelated ones
+	inline constexpr uint64_t mix(uint64_t x)
+	{
+		x += 0x9e3779b97f4a7c15;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+		return x ^ (x >> 31);
+	}
+	
+	// xoshiro256**: a few shifts and multiplies a number, no system calls, the same numbers for the same seed
+	// everywhere; streams of one seed are independent of each other, as for the rows of a world
+	class generator
+	{
+	public:
+		explicit generator(uint64_t seed, uint64_t stream = 0);
+		uint64_t operator () ();
+		// uniform in [0, count), count is not zero
+		uint32_t below(uint32_t count);
+		// 64 cells each alive with the given percent of chance
+		uint64_t cells(uint32_t density);
+	private:
+		uint64_t m_state[4];
+	};
+	
+	// the whole world at random with the given percent of living cells, rows are shared out between the workers;
+	// every row has a stream of its own, so the world depends on the seed only and not on the number of workers
+	void fill(grid & world, uint64_t seed, uint32_t density, pool & workers);
+}
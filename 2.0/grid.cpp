@@ -0,0 +1,66 @@
+//
+//  grid.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "grid.h"
+#include <bit>
+#include <algorithm>
+
+namespace game
+{
+	grid::grid() : m_width(), m_height(), m_stride()
+	{
+		
+	}
+	
+	grid::grid(uint32_t width, uint32_t height) : grid()
+	{
+		resize(width, height);
+	}
+	
+	void grid::resize(uint32_t width, uint32_t height)
+	{
+		m_width = width;
+		m_height = height;
+		m_stride = static_cast<uint32_t>((uint64_t {width} + 63) / 64);
+		m_words.assign(static_cast<std::size_t>(m_stride) * m_height, 0);
+	}
+	
+	void grid::clear()
+	{
+		std::fill(m_words.begin(), m_words.end(), 0);
+	}
+	
+	bool grid::empty() const
+	{
+		return std::all_of(m_words.cbegin(), m_words.cend(), [](uint64_t word) -> bool { return word == 0; });
+	}
+	
+	uint64_t grid::population() const
+	{
+		uint64_t count {};
+		for (uint64_t word : m_words)
+		{
+			count += std::popcount(word);
+		}
+		return count;
+	}
+	
+	uint64_t grid::hash() const
+	{
+		uint64_t h {};
+		for (std::size_t i {}; i < m_words.size(); ++i)
+		{
+			h ^= word_hash(i, m_words[i]);
+		}
+		return h;
+	}
+	
+	bool operator == (const grid & lhs, const grid & rhs)
+	{
+		return lhs.m_width == rhs.m_width && lhs.m_height == rhs.m_height && lhs.m_words == rhs.m_words;
+	}
+}
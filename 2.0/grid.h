@@ -0,0 +1,84 @@
+//
+//  grid.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace game
+{
+	// world packed one bit per cell, 64 cells per word;
+	// every row starts at a word boundary and unused bits of the last word in a row are always zero
+	class grid
+	{
+	public:
+		grid();
+		grid(uint32_t width, uint32_t height);
+		void resize(uint32_t width, uint32_t height);
+		void clear();
+		bool empty() const;
+		uint64_t population() const;
+		uint32_t width() const { return m_width; }
+		uint32_t height() const { return m_height; }
+		uint32_t stride() const { return m_stride; }				// words per row
+		uint64_t * row(uint32_t y) { return m_words.data() + static_cast<std::size_t>(y) * m_stride; }
+		const uint64_t * row(uint32_t y) const { return m_words.data() + static_cast<std::size_t>(y) * m_stride; }
+		bool get(uint32_t x, uint32_t y) const;
+		void set(uint32_t x, uint32_t y, bool alive);
+		friend bool operator == (const grid & lhs, const grid & rhs);
+		// XOR of word_hash() over all the words
+		uint64_t hash() const;
+	private:
+		uint32_t m_width;
+		uint32_t m_height;
+		uint32_t m_stride;
+		std::vector<uint64_t> m_words;
+	};
+	
+	// what a generation changes in a part of the world: the hash is XORed with the one it had before,
+	// births and deaths are cells that came alive and died, so the population moves by their difference
+	struct changes
+	{
+		uint64_t hash;
+		uint64_t births;
+		uint64_t deaths;
+		
+		changes & operator += (const changes & other)
+		{
+			hash ^= other.hash;
+			births += other.births;
+			deaths += other.deaths;
+			return *this;
+		}
+	};
+	
+	// multipliers of word_hash(), the vector kernels compute the same values
+	inline constexpr uint64_t hash_index {0x9e3779b97f4a7c15};
+	inline constexpr uint64_t hash_low {0xed558ccd};
+	inline constexpr uint64_t hash_high {0x1a85ec53};
+	
+	// Zobrist-style hash of a word of cells at the given index in the grid: XOR of these values over the words
+	// is the hash of the grid, so a new generation's hash follows from the words that changed alone;
+	// it takes two 32-bit multiplications, which vector units do for several words at once
+	inline uint64_t word_hash(std::size_t index, uint64_t word)
+	{
+		const uint64_t h {word ^ (index * hash_index)};
+		return (h & 0xffffffff) * hash_low ^ (h >> 32) * hash_high;
+	}
+	
+	inline bool grid::get(uint32_t x, uint32_t y) const
+	{
+		return (row(y)[x >> 6] >> (x & 63)) & 1;
+	}
+	
+	inline void grid::set(uint32_t x, uint32_t y, bool alive)
+	{
+		uint64_t & word {row(y)[x >> 6]};
+		const uint64_t mask {uint64_t {1} << (x & 63)};
+		word = alive ? word | mask : word & ~mask;
+	}
+}
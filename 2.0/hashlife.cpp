@@ -0,0 +1,380 @@
+//
+//  hashlife.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "hashlife.h"
+#include <bit>
+#include <algorithm>
+
+// root node of level L covers cells [-2^(L-1), 2^(L-1)) on both axes, so its result, the centre
+// of level L - 1, covers [-2^(L-2), 2^(L-2)) and the origin stays in place after every advance
+
+namespace
+{
+	constexpr uint32_t none {0xffffffff};
+	constexpr uint32_t dead {0};
+	constexpr uint32_t alive {1};
+	constexpr std::size_t smallest_table {1 << 16};
+	
+	// thrown from deep in an advance when the nodes outgrow the limit, so the jump can start again after a collection
+	struct out_of_cache
+	{
+		
+	};
+	
+	inline uint64_t hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+	{
+		uint64_t h {nw * 0x9e3779b97f4a7c15};
+		h = (h ^ (h >> 29) ^ ne) * 0xbf58476d1ce4e5b9;
+		h = (h ^ (h >> 29) ^ sw) * 0x94d049bb133111eb;
+		h = (h ^ (h >> 29) ^ se) * 0x9e3779b97f4a7c15;
+		return h ^ (h >> 32);
+	}
+}
+
+namespace game
+{
+	hashlife::hashlife(uint32_t step_exponent, uint64_t cache_bytes) : m_rule(conway),
+	                                                                   m_root(),
+	                                                                   m_step_exponent(step_exponent),
+	                                                                   m_cache_bytes(cache_bytes),
+	                                                                   m_limit(cache_bytes),
+	                                                                   m_jumping(false)
+	{
+		clear(m_rule);
+	}
+	
+	// results of the nodes belong to the rule they were computed by, so they are dropped together with the nodes
+	void hashlife::clear(const rule & r)
+	{
+		m_rule = r;
+		m_nodes.clear();
+		m_empty.clear();
+		m_table.assign(smallest_table, none);
+		m_limit = m_cache_bytes;
+		m_nodes.push_back({none, none, none, none, none, 0, 0});
+		m_nodes.push_back({none, none, none, none, none, 0, 1});
+		m_root = empty(3);
+	}
+	
+	void hashlife::set(int64_t x, int64_t y)
+	{
+		int64_t half {int64_t {1} << (m_nodes.at(m_root).level - 1)};
+		while (x < -half || x >= half || y < -half || y >= half)
+		{
+			m_root = expand(m_root);
+			half <<= 1;
+		}
+		m_root = set(m_root, static_cast<uint64_t>(x + half), static_cast<uint64_t>(y + half));
+	}
+	
+	void hashlife::advance()
+	{
+		if (memory() > m_limit)
+		{
+			collect();
+		}
+		// the pattern must sit in the middle quarter of the root, then it can not spread
+		// out of the centre in 2^k <= 2^(level - 3) generations
+		while (m_nodes.at(m_root).level < m_step_exponent + 3 ||
+		       m_nodes.at(m_root).population != m_nodes.at(centre(centre(m_root))).population)
+		{
+			m_root = expand(m_root);
+		}
+		// a jump running out of memory is thrown away and done again after a collection; the second try
+		// is not stopped, a single jump needing more than the limit still has to finish
+		m_jumping = true;
+		try
+		{
+			m_root = successor(m_root);
+		}
+		catch (const out_of_cache &)
+		{
+			m_jumping = false;
+			collect();
+			m_root = successor(m_root);
+		}
+		m_jumping = false;
+	}
+	
+	uint64_t hashlife::step() const
+	{
+		return uint64_t {1} << m_step_exponent;
+	}
+	
+	uint64_t hashlife::population() const
+	{
+		return m_nodes.at(m_root).population;
+	}
+	
+	void hashlife::read(grid & window, int64_t left, int64_t top) const
+	{
+		window.clear();
+		const int64_t half {int64_t {1} << (m_nodes.at(m_root).level - 1)};
+		read(m_root, -half, -half, window, left, top);
+	}
+	
+	uint32_t hashlife::join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+	{
+		const uint64_t mask {m_table.size() - 1};
+		for (uint64_t i {hash(nw, ne, sw, se) & mask}; ; i = (i + 1) & mask)
+		{
+			const uint32_t index {m_table[i]};
+			if (index == none)
+			{
+				break;
+			}
+			const node & n {m_nodes[index]};
+			if (n.nw == nw && n.ne == ne && n.sw == sw && n.se == se)
+			{
+				return index;
+			}
+		}
+		const uint64_t population {m_nodes[nw].population + m_nodes[ne].population + m_nodes[sw].population + m_nodes[se].population};
+		if (m_jumping && memory() > m_limit)
+		{
+			throw out_of_cache {};
+		}
+		m_nodes.push_back({nw, ne, sw, se, none, m_nodes[nw].level + 1, population});
+		const uint32_t index {static_cast<uint32_t>(m_nodes.size() - 1)};
+		// keep the table at most half full, so probe sequences stay short
+		if (m_nodes.size() * 2 > m_table.size())
+		{
+			m_table.assign(m_table.size() * 2, none);
+			for (uint32_t i {alive + 1}; i <= index; ++i)
+			{
+				insert(i);
+			}
+		}
+		else
+		{
+			insert(index);
+		}
+		return index;
+	}
+	
+	void hashlife::insert(uint32_t index)
+	{
+		const node & n {m_nodes[index]};
+		const uint64_t mask {m_table.size() - 1};
+		uint64_t i {hash(n.nw, n.ne, n.sw, n.se) & mask};
+		while (m_table[i] != none)
+		{
+			i = (i + 1) & mask;
+		}
+		m_table[i] = index;
+	}
+	
+	uint32_t hashlife::empty(uint32_t level)
+	{
+		if (level == 0)
+		{
+			return dead;
+		}
+		while (m_empty.size() < level)
+		{
+			const uint32_t child {m_empty.empty() ? dead : m_empty.back()};
+			m_empty.push_back(join(child, child, child, child));
+		}
+		return m_empty.at(level - 1);
+	}
+	
+	// same cells one level up, in the middle of the new node
+	uint32_t hashlife::expand(uint32_t index)
+	{
+		const node n {m_nodes.at(index)};
+		const uint32_t border {empty(n.level - 1)};
+		return join(join(border, border, border, n.nw), join(border, border, n.ne, border),
+		            join(border, n.sw, border, border), join(n.se, border, border, border));
+	}
+	
+	uint32_t hashlife::centre(uint32_t index)
+	{
+		const node n {m_nodes.at(index)};
+		return join(m_nodes[n.nw].se, m_nodes[n.ne].sw, m_nodes[n.sw].ne, m_nodes[n.se].nw);
+	}
+	
+	uint32_t hashlife::successor(uint32_t index)
+	{
+		const node n {m_nodes.at(index)};
+		if (n.result != none)
+		{
+			return n.result;
+		}
+		uint32_t result {};
+		if (n.population == 0)
+		{
+			result = empty(n.level - 1);
+		}
+		else if (n.level == 2)
+		{
+			result = base(index);
+		}
+		else
+		{
+			const node nw {m_nodes[n.nw]};
+			const node ne {m_nodes[n.ne]};
+			const node sw {m_nodes[n.sw]};
+			const node se {m_nodes[n.se]};
+			// nine overlapping squares of level - 1 moved forward in time, each leaves its centre of level - 2
+			const uint32_t r00 {successor(n.nw)};
+			const uint32_t r01 {successor(join(nw.ne, ne.nw, nw.se, ne.sw))};
+			const uint32_t r02 {successor(n.ne)};
+			const uint32_t r10 {successor(join(nw.sw, nw.se, sw.nw, sw.ne))};
+			const uint32_t r11 {successor(join(nw.se, ne.sw, sw.ne, se.nw))};
+			const uint32_t r12 {successor(join(ne.sw, ne.se, se.nw, se.ne))};
+			const uint32_t r20 {successor(n.sw)};
+			const uint32_t r21 {successor(join(sw.ne, se.nw, sw.se, se.sw))};
+			const uint32_t r22 {successor(n.se)};
+			const uint32_t q0 {join(r00, r01, r10, r11)};
+			const uint32_t q1 {join(r01, r02, r11, r12)};
+			const uint32_t q2 {join(r10, r11, r20, r21)};
+			const uint32_t q3 {join(r11, r12, r21, r22)};
+			// at full speed the four quarters are moved forward once more, doubling the jump;
+			// for shorter steps only their centres are taken
+			if (m_step_exponent >= n.level - 2)
+			{
+				result = join(successor(q0), successor(q1), successor(q2), successor(q3));
+			}
+			else
+			{
+				result = join(centre(q0), centre(q1), centre(q2), centre(q3));
+			}
+		}
+		m_nodes[index].result = result;
+		return result;
+	}
+	
+	// one generation of the centre 2x2 cells of a 4x4 node
+	uint32_t hashlife::base(uint32_t index)
+	{
+		uint32_t bits {};
+		for (uint32_t y {}; y < 4; ++y)
+		{
+			for (uint32_t x {}; x < 4; ++x)
+			{
+				bits |= static_cast<uint32_t>(cell(index, x, y)) << (y * 4 + x);
+			}
+		}
+		auto next {[bits, this](uint32_t x, uint32_t y) -> uint32_t
+			{
+				uint32_t count {};
+				for (uint32_t j {y - 1}; j <= y + 1; ++j)
+				{
+					for (uint32_t i {x - 1}; i <= x + 1; ++i)
+					{
+						if (!(i == x && j == y))
+						{
+							count += (bits >> (j * 4 + i)) & 1;
+						}
+					}
+				}
+				const bool living {static_cast<bool>((bits >> (y * 4 + x)) & 1)};
+				return (((living ? m_rule.survival : m_rule.birth) >> count) & 1) ? alive : dead;
+			}};
+		return join(next(1, 1), next(2, 1), next(1, 2), next(2, 2));
+	}
+	
+	uint32_t hashlife::set(uint32_t index, uint64_t x, uint64_t y)
+	{
+		const node n {m_nodes.at(index)};
+		if (n.level == 0)
+		{
+			return alive;
+		}
+		const uint64_t half {uint64_t {1} << (n.level - 1)};
+		if (y < half)
+		{
+			return x < half ? join(set(n.nw, x, y), n.ne, n.sw, n.se) : join(n.nw, set(n.ne, x - half, y), n.sw, n.se);
+		}
+		return x < half ? join(n.nw, n.ne, set(n.sw, x, y - half), n.se) : join(n.nw, n.ne, n.sw, set(n.se, x - half, y - half));
+	}
+	
+	bool hashlife::cell(uint32_t index, uint32_t x, uint32_t y) const
+	{
+		while (m_nodes[index].level > 0)
+		{
+			const node & n {m_nodes[index]};
+			const uint32_t half {1u << (n.level - 1)};
+			index = y < half ? (x < half ? n.nw : n.ne) : (x < half ? n.sw : n.se);
+			x &= half - 1;
+			y &= half - 1;
+		}
+		return index == alive;
+	}
+	
+	void hashlife::read(uint32_t index, int64_t x, int64_t y, grid & window, int64_t left, int64_t top) const
+	{
+		const node & n {m_nodes[index]};
+		const int64_t size {int64_t {1} << n.level};
+		if (n.population == 0 || x + size <= left || y + size <= top ||
+		    x >= left + window.width() || y >= top + window.height())
+		{
+			return;
+		}
+		if (n.level == 0)
+		{
+			window.set(static_cast<uint32_t>(x - left), static_cast<uint32_t>(y - top), true);
+			return;
+		}
+		const int64_t half {size / 2};
+		read(n.nw, x, y, window, left, top);
+		read(n.ne, x + half, y, window, left, top);
+		read(n.sw, x, y + half, window, left, top);
+		read(n.se, x + half, y + half, window, left, top);
+	}
+	
+	// keeps only the nodes reachable from the root and the empty ones, memoized results are dropped;
+	// children are always created before their parents, so new indices can be given in one pass
+	void hashlife::collect()
+	{
+		std::vector<bool> marked(m_nodes.size());
+		std::vector<uint32_t> stack {m_root};
+		stack.insert(stack.end(), m_empty.cbegin(), m_empty.cend());
+		while (!stack.empty())
+		{
+			const uint32_t index {stack.back()};
+			stack.pop_back();
+			if (index <= alive || marked[index])
+			{
+				continue;
+			}
+			marked[index] = true;
+			const node & n {m_nodes[index]};
+			stack.insert(stack.end(), {n.nw, n.ne, n.sw, n.se});
+		}
+		std::vector<uint32_t> remap(m_nodes.size(), none);
+		remap[dead] = dead;
+		remap[alive] = alive;
+		std::vector<node> nodes {m_nodes[dead], m_nodes[alive]};
+		for (uint32_t index {alive + 1}; index < m_nodes.size(); ++index)
+		{
+			if (marked[index])
+			{
+				const node & n {m_nodes[index]};
+				remap[index] = static_cast<uint32_t>(nodes.size());
+				nodes.push_back({remap[n.nw], remap[n.ne], remap[n.sw], remap[n.se], none, n.level, n.population});
+			}
+		}
+		m_nodes = std::move(nodes);
+		m_root = remap[m_root];
+		std::transform(m_empty.cbegin(), m_empty.cend(), m_empty.begin(), [&remap](uint32_t index) { return remap[index]; });
+		// the table shrinks with the nodes, at most half full as join() keeps it
+		m_table.assign(std::bit_ceil(std::max(m_nodes.size() * 2, smallest_table)), none);
+		m_table.shrink_to_fit();
+		for (uint32_t index {alive + 1}; index < m_nodes.size(); ++index)
+		{
+			insert(index);
+		}
+		// nodes still in use are not collected again and again: the next collection waits until as many are added
+		m_limit = std::max(m_cache_bytes, memory() * 2);
+	}
+	
+	uint64_t hashlife::memory() const
+	{
+		return m_nodes.size() * sizeof(node) + m_table.size() * sizeof(uint32_t);
+	}
+}
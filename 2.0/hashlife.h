@@ -0,0 +1,61 @@
+//
+//  hashlife.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "universe.h"
+#include <vector>
+
+namespace game
+{
+	// HashLife: the plane is a quadtree of square nodes 2^level cells wide, equal nodes are stored once
+	// and every node remembers its centre advanced in time, so repeating patterns are computed only once
+	// and a single advance can jump 2^k generations
+	class hashlife : public universe
+	{
+	public:
+		hashlife(uint32_t step_exponent, uint64_t cache_bytes);
+		void clear(const rule & r) override;
+		void set(int64_t x, int64_t y) override;
+		void advance() override;
+		uint64_t step() const override;
+		uint64_t population() const override;
+		void read(grid & window, int64_t left, int64_t top) const override;
+	private:
+		struct node
+		{
+			uint32_t nw;
+			uint32_t ne;
+			uint32_t sw;
+			uint32_t se;
+			uint32_t result;										// centre of the node after 2^min(k, level - 2) generations
+			uint32_t level;
+			uint64_t population;
+		};
+		uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+		uint32_t empty(uint32_t level);
+		uint32_t expand(uint32_t index);
+		uint32_t centre(uint32_t index);
+		uint32_t successor(uint32_t index);
+		uint32_t base(uint32_t index);
+		uint32_t set(uint32_t index, uint64_t x, uint64_t y);
+		bool cell(uint32_t index, uint32_t x, uint32_t y) const;
+		void read(uint32_t index, int64_t x, int64_t y, grid & window, int64_t left, int64_t top) const;
+		void insert(uint32_t index);
+		void collect();
+		uint64_t memory() const;
+	private:
+		rule m_rule;
+		uint32_t m_root;
+		uint32_t m_step_exponent;
+		uint64_t m_cache_bytes;										// garbage is collected once nodes take more memory
+		uint64_t m_limit;											// memory collected at, twice what survived if that is more
+		bool m_jumping;												// an advance is running and stops if memory runs out
+		std::vector<node> m_nodes;									// level 0 nodes are dead and alive cells at index 0 and 1
+		std::vector<uint32_t> m_table;								// open addressing hash table of node indices
+		std::vector<uint32_t> m_empty;								// empty node of every level
+	};
+}
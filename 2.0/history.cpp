@@ -0,0 +1,96 @@
+//
+//  history.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "history.h"
+#include <bit>
+#include <algorithm>
+
+namespace
+{
+	// hashes of worlds have no final mixing step, so their low bits depend on a few columns only;
+	// the splitmix64 finalizer spreads every bit over the slot taken from the low ones
+	std::size_t slot(uint64_t hash, std::size_t mask)
+	{
+		hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+		hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+		return (hash ^ (hash >> 31)) & mask;
+	}
+}
+
+namespace game
+{
+	// tables are kept at most half full, so probe sequences stay short
+	history::history(uint32_t limit) : m_limit(limit),
+	                                   m_steps(),
+	                                   m_cleared(),
+	                                   m_size(),
+	                                   m_newer(std::bit_ceil(std::max(limit, 1u) * std::size_t {2})),
+	                                   m_older(m_newer.size())
+	{
+		
+	}
+	
+	void history::clear()
+	{
+		m_cleared = m_steps;
+		m_size = 0;
+	}
+	
+	history::match history::add(uint64_t hash, uint64_t generation)
+	{
+		++m_steps;
+		// newer table holds the latest generation with the hash, the older one is looked at only if there is none
+		const entry * found {find(m_newer, hash)};
+		if (found == nullptr)
+		{
+			found = find(m_older, hash);
+		}
+		match result {};
+		if (found != nullptr && m_steps - found->step <= m_limit)
+		{
+			result = {m_steps - found->step, found->generation};
+		}
+		if (m_size == m_limit)
+		{
+			m_older.swap(m_newer);
+			std::fill(m_newer.begin(), m_newer.end(), entry {});
+			m_size = 0;
+		}
+		insert({hash, generation, m_steps});
+		return result;
+	}
+	
+	uint64_t history::steps() const
+	{
+		return m_steps - m_cleared;
+	}
+	
+	const history::entry * history::find(const std::vector<entry> & table, uint64_t hash) const
+	{
+		const std::size_t mask {table.size() - 1};
+		for (std::size_t i {slot(hash, mask)}; table[i].step > m_cleared; i = (i + 1) & mask)
+		{
+			if (table[i].hash == hash)
+			{
+				return &table[i];
+			}
+		}
+		return nullptr;
+	}
+	
+	void history::insert(const entry & e)
+	{
+		const std::size_t mask {m_newer.size() - 1};
+		std::size_t i {slot(e.hash, mask)};
+		while (m_newer[i].step > m_cleared && m_newer[i].hash != e.hash)
+		{
+			i = (i + 1) & mask;
+		}
+		m_size += m_newer[i].step <= m_cleared;
+		m_newer[i] = e;
+	}
+}
@@ -0,0 +1,49 @@
+//
+//  history.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace game
+{
+	// hashes of the latest generations, used to find the one a new generation repeats; two tables take turns,
+	// the older one is dropped whenever the newer one holds limit generations, so every generation within the limit
+	// is kept without removing entries one by one; clearing only moves the step entries count as empty up to,
+	// so a history reused for many short games costs nothing to clear
+	class history
+	{
+	public:
+		// generation repeated by the one added and the number of steps back to it, no steps if there is none
+		struct match
+		{
+			uint64_t steps;
+			uint64_t generation;
+		};
+		explicit history(uint32_t limit);
+		void clear();
+		match add(uint64_t hash, uint64_t generation);
+		// generations added since the last clear()
+		uint64_t steps() const;
+	private:
+		struct entry
+		{
+			uint64_t hash;
+			uint64_t generation;
+			uint64_t step;											// empty if not past m_cleared
+		};
+		const entry * find(const std::vector<entry> & table, uint64_t hash) const;
+		void insert(const entry & e);
+	private:
+		const uint32_t m_limit;
+		uint64_t m_steps;
+		uint64_t m_cleared;											// steps at the last clear()
+		uint32_t m_size;											// entries in the newer table
+		std::vector<entry> m_newer;
+		std::vector<entry> m_older;
+	};
+}
@@ -0,0 +1,302 @@
+//
+//  kernel.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "kernel.h"
+#include "kernel_simd.h"
+#include <algorithm>
+#include <bit>
+#if defined(GAME_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	using game::evolve;
+	using game::policy;
+	
+	inline bool first_cell(const uint64_t * row)
+	{
+		return row[0] & 1;
+	}
+	
+	inline bool last_cell(const uint64_t * row, uint32_t width)
+	{
+		return (row[(width - 1) >> 6] >> ((width - 1) & 63)) & 1;
+	}
+	
+	// neighbours to the west of 64 cells in a word: cell x - 1 moved to bit of cell x,
+	// the first cell in a row takes the last one
+	inline uint64_t west(const uint64_t * row, uint32_t w, uint32_t width)
+	{
+		const uint64_t carry {w > 0 ? row[w - 1] >> 63 : static_cast<uint64_t>(last_cell(row, width))};
+		return (row[w] << 1) | carry;
+	}
+	
+	// neighbours to the east: cell x + 1 moved to bit of cell x, the last cell in a row takes the first one
+	inline uint64_t east(const uint64_t * row, uint32_t w, uint32_t stride, uint32_t width)
+	{
+		if (w + 1 < stride)
+		{
+			return (row[w] >> 1) | (row[w + 1] << 63);
+		}
+		return (row[w] >> 1) | (static_cast<uint64_t>(first_cell(row)) << ((width - 1) & 63));
+	}
+	
+	// next generation of a word at either end of a row, where neighbours wrap around
+	template <typename Rule>
+	uint64_t step_edge(const uint64_t * top, const uint64_t * middle, const uint64_t * bottom, uint32_t w, uint32_t stride, uint32_t width, const game::table_rule & table)
+	{
+		return evolve(policy<Rule>(table),
+		              west(top, w, width), top[w], east(top, w, stride, width),
+		              west(middle, w, width), middle[w], east(middle, w, stride, width),
+		              west(bottom, w, width), bottom[w], east(bottom, w, stride, width));
+	}
+	
+	template <typename Rule>
+	uint32_t step_interior_scalar(const uint64_t * top, const uint64_t * middle, const uint64_t * bottom, uint64_t * out, uint32_t first, uint32_t last, const game::table_rule & table)
+	{
+		// a copy of the table can not change through out, so its masks stay in registers
+		const Rule rule {policy<Rule>(table)};
+		for (uint32_t w {first}; w < last; ++w)
+		{
+			out[w] = evolve(rule, (top[w] << 1) | (top[w - 1] >> 63), top[w], (top[w] >> 1) | (top[w + 1] << 63),
+			                      (middle[w] << 1) | (middle[w - 1] >> 63), middle[w], (middle[w] >> 1) | (middle[w + 1] << 63),
+			                      (bottom[w] << 1) | (bottom[w - 1] >> 63), bottom[w], (bottom[w] >> 1) | (bottom[w + 1] << 63));
+		}
+		return last;
+	}
+	
+	template <typename Rule>
+	void step_soups_scalar(const uint64_t * src, uint64_t * dst, uint32_t width, uint32_t height, const game::table_rule & table)
+	{
+		const Rule rule {policy<Rule>(table)};
+		const uint64_t mask {width == 64 ? ~uint64_t {} : (uint64_t {1} << width) - 1};
+		for (uint32_t y {}; y < height; ++y)
+		{
+			const uint64_t * top {src + static_cast<std::size_t>((y + height - 1) % height) * game::soup_lanes};
+			const uint64_t * middle {src + static_cast<std::size_t>(y) * game::soup_lanes};
+			const uint64_t * bottom {src + static_cast<std::size_t>((y + 1) % height) * game::soup_lanes};
+			uint64_t * out {dst + static_cast<std::size_t>(y) * game::soup_lanes};
+			for (uint32_t i {}; i < game::soup_lanes; ++i)
+			{
+				out[i] = mask & evolve(rule, game::soup_west(top[i], width, mask), top[i], game::soup_east(top[i], width),
+				                             game::soup_west(middle[i], width, mask), middle[i], game::soup_east(middle[i], width),
+				                             game::soup_west(bottom[i], width, mask), bottom[i], game::soup_east(bottom[i], width));
+			}
+		}
+	}
+	
+	game::interior_kernel interior_scalar(const game::rule & r)
+	{
+		return game::with_rule(r, []<typename Rule>(const Rule &) -> game::interior_kernel
+		{
+			return step_interior_scalar<Rule>;
+		});
+	}
+	
+	game::edge_kernel edge(const game::rule & r)
+	{
+		return game::with_rule(r, []<typename Rule>(const Rule &) -> game::edge_kernel
+		{
+			return step_edge<Rule>;
+		});
+	}
+	
+	game::soup_kernel soups_scalar(const game::rule & r)
+	{
+		return game::with_rule(r, []<typename Rule>(const Rule &) -> game::soup_kernel
+		{
+			return step_soups_scalar<Rule>;
+		});
+	}
+	
+	uint32_t compare_scalar(const uint64_t * before, const uint64_t * after, uint64_t index, uint32_t first, uint32_t last, game::changes & result)
+	{
+		for (uint32_t w {first}; w < last; ++w)
+		{
+			result.hash ^= game::word_hash(index + w, before[w]) ^ game::word_hash(index + w, after[w]);
+			result.births += std::popcount(after[w] & ~before[w]);
+			result.deaths += std::popcount(before[w] & ~after[w]);
+		}
+		return last;
+	}
+	
+	template <uint32_t planes>
+	uint32_t fade_scalar(const game::dying_row & row, uint32_t first, uint32_t last, uint64_t & hash)
+	{
+		for (uint32_t w {first}; w < last; ++w)
+		{
+			game::fade_word<planes>(row, w, hash);
+		}
+		return last;
+	}
+	
+	game::decay_kernel decay_scalar(uint32_t planes)
+	{
+		switch (planes)
+		{
+			case 1: return fade_scalar<1>;
+			case 2: return fade_scalar<2>;
+			default: return fade_scalar<3>;
+		}
+	}
+	
+	struct isa
+	{
+		std::string_view name;
+		game::interior_kernel (* interior)(const game::rule & r);	// kernel of the instruction set made for the rule
+		game::simd::compare_kernel compare;
+		game::soup_kernel (* soups)(const game::rule & r);
+		game::decay_kernel (* decay)(uint32_t planes);
+	};
+	
+	// picks the widest instruction set supported by the host, so the same binary runs everywhere
+	isa select_isa()
+	{
+#ifdef GAME_SIMD_X86
+		if (game::simd::has_avx512())
+		{
+			return {"avx512", game::simd::interior_avx512, game::simd::compare_avx512, game::simd::soups_avx512, game::simd::decay_avx512};
+		}
+		if (game::simd::has_avx2())
+		{
+			return {"avx2", game::simd::interior_avx2, game::simd::compare_avx2, game::simd::soups_avx2, game::simd::decay_avx2};
+		}
+#endif
+		return {"scalar", interior_scalar, compare_scalar, soups_scalar, decay_scalar};
+	}
+	
+	const isa & host_isa()
+	{
+		static const isa selected {select_isa()};
+		return selected;
+	}
+}
+
+namespace game
+{
+	kernel::kernel() : kernel(conway)
+	{
+		
+	}
+	
+	kernel::kernel(const game::rule & r) : m_rule(r),
+	                                       m_table(r),
+	                                       m_vector(host_isa().interior(r)),
+	                                       m_scalar(interior_scalar(r)),
+	                                       m_edge(edge(r)),
+	                                       m_soups(host_isa().soups(r))
+	{
+		
+	}
+	
+	void kernel::step(const grid & src, grid & dst, uint32_t first, uint32_t last) const
+	{
+		for (uint32_t y {first}; y < last; ++y)
+		{
+			step_span(src, dst, y, 0, src.stride());
+		}
+	}
+	
+	void kernel::step_span(const grid & src, grid & dst, uint32_t y, uint32_t first, uint32_t last) const
+	{
+		const uint32_t width {src.width()};
+		const uint32_t height {src.height()};
+		const uint32_t stride {src.stride()};
+		const uint64_t * top {src.row((y + height - 1) % height)};
+		const uint64_t * middle {src.row(y)};
+		const uint64_t * bottom {src.row((y + 1) % height)};
+		uint64_t * out {dst.row(y)};
+		// words at both ends of a row wrap around, the ones in between have both neighbour words at hand
+		uint32_t w {first};
+		if (w == 0)
+		{
+			out[0] = m_edge(top, middle, bottom, 0, stride, width, m_table);
+			++w;
+		}
+		const uint32_t interior_last {std::min(last, stride - 1)};
+		if (w < interior_last)
+		{
+			w = m_vector(top, middle, bottom, out, w, interior_last, m_table);
+			w = m_scalar(top, middle, bottom, out, w, interior_last, m_table);
+		}
+		if (last == stride)
+		{
+			if (w < stride)
+			{
+				out[stride - 1] = m_edge(top, middle, bottom, stride - 1, stride, width, m_table);
+			}
+			// mask of cells that belong to the world in the last word of a row
+			out[stride - 1] &= (width & 63) ? (uint64_t {1} << (width & 63)) - 1 : ~uint64_t {};
+		}
+	}
+	
+	void kernel::step_soups(const uint64_t * src, uint64_t * dst, uint32_t width, uint32_t height) const
+	{
+		m_soups(src, dst, width, height, m_table);
+	}
+	
+	changes compare(const grid & before, const grid & after, uint32_t y, uint32_t first, uint32_t last)
+	{
+		const uint64_t index {static_cast<uint64_t>(y) * before.stride()};
+		changes result {};
+		const uint32_t w {host_isa().compare(before.row(y), after.row(y), index, first, last, result)};
+		compare_scalar(before.row(y), after.row(y), index, w, last, result);
+		return result;
+	}
+	
+	uint64_t fade(const dying_row & row, uint32_t first, uint32_t last)
+	{
+		uint64_t hash {};
+		const uint32_t w {host_isa().decay(row.count)(row, first, last, hash)};
+		decay_scalar(row.count)(row, w, last, hash);
+		return hash;
+	}
+	
+	std::string_view step_isa()
+	{
+		return host_isa().name;
+	}
+
+#ifdef GAME_SIMD_X86
+	namespace simd
+	{
+		bool has_avx2()
+		{
+#ifdef _MSC_VER
+			int info[4] {};
+			__cpuid(info, 0);
+			if (info[0] < 7) { return false; }
+			__cpuid(info, 1);
+			// OSXSAVE and AVX, then the OS must save YMM state
+			if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) { return false; }
+			if ((_xgetbv(0) & 0x6) != 0x6) { return false; }
+			__cpuidex(info, 7, 0);
+			return info[1] & (1 << 5);
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+		
+		bool has_avx512()
+		{
+#ifdef _MSC_VER
+			if (!has_avx2()) { return false; }
+			// the OS must save opmask and ZMM state as well
+			if ((_xgetbv(0) & 0xe6) != 0xe6) { return false; }
+			int info[4] {};
+			__cpuidex(info, 7, 0);
+			return info[1] & (1 << 16);
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx512f");
+#endif
+		}
+	}
+#endif
+}
@@ -0,0 +1,246 @@
+//
+//  kernel.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include "rule.h"
+#include <utility>
+#include <type_traits>
+#include <string_view>
+
+// cells are counted bit-parallel: every word holds 64 cells and the eight neighbours of those cells
+// are eight words, shifted so that each neighbour lines up with the cell it belongs to;
+// adding eight words bit by bit with full adders gives a 4-bit count per cell spread over four words
+
+namespace game
+{
+	inline void half_add(uint64_t a, uint64_t b, uint64_t & sum, uint64_t & carry)
+	{
+		sum = a ^ b;
+		carry = a & b;
+	}
+	
+	inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t & sum, uint64_t & carry)
+	{
+		const uint64_t t {a ^ b};
+		sum = t ^ c;
+		carry = (a & b) | (t & c);
+	}
+	
+	// rule fixed at compile time: its masks are constants, so a kernel made for it keeps only the operations the rule needs
+	template <rule r>
+	struct fixed_rule
+	{
+		static constexpr uint64_t birth(uint32_t n) { return (r.birth >> n) & 1 ? ~uint64_t {} : 0; }
+		static constexpr uint64_t survival(uint32_t n) { return (r.survival >> n) & 1 ? ~uint64_t {} : 0; }
+	};
+	
+	// any other rule, its masks are read from a table
+	struct table_rule
+	{
+		table_rule() : table_rule(conway)
+		{
+			
+		}
+		
+		explicit table_rule(const rule & r)
+		{
+			for (uint32_t n {}; n < 9; ++n)
+			{
+				births[n] = (r.birth >> n) & 1 ? ~uint64_t {} : 0;
+				survivals[n] = (r.survival >> n) & 1 ? ~uint64_t {} : 0;
+			}
+		}
+		
+		uint64_t birth(uint32_t n) const { return births[n]; }
+		uint64_t survival(uint32_t n) const { return survivals[n]; }
+		uint64_t births[9];
+		uint64_t survivals[9];
+	};
+	
+	// calls f with the policy of the rule, a fixed one for the rules kernels are compiled for
+	// and a table for the rest, so the choice is made once instead of for every word
+	template <typename F>
+	auto with_rule(const rule & r, F && f)
+	{
+		const rule counts {life_like(r)};
+		if (counts == conway) { return f(fixed_rule<conway> {}); }
+		if (counts == highlife) { return f(fixed_rule<highlife> {}); }
+		if (counts == day_and_night) { return f(fixed_rule<day_and_night> {}); }
+		if (counts == seeds) { return f(fixed_rule<seeds> {}); }
+		return f(table_rule {counts});
+	}
+	
+	// policy of the rule a kernel was made for: fixed rules carry nothing, a table is the one passed to the kernel
+	template <typename Rule>
+	inline const Rule & policy(const table_rule & table)
+	{
+		if constexpr (std::is_same_v<Rule, table_rule>)
+		{
+			return table;
+		}
+		else
+		{
+			static constexpr Rule fixed {};
+			return fixed;
+		}
+	}
+	
+	// next state of 64 cells out of the 4-bit count of their neighbours and their state: the count is split
+	// into masks of its two low bits and of the rest, so every count from 0 to 8 is the AND of two of them,
+	// counts above 8 can not happen; then the rule picks the counts a cell is born and survives with
+	template <typename Rule>
+	inline uint64_t apply(const Rule & rule, uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3, uint64_t alive)
+	{
+		if constexpr (std::is_same_v<Rule, fixed_rule<conway>>)
+		{
+			// cell is alive with 3 neighbours, or with 2 neighbours if it was alive before
+			return ~s3 & ~s2 & s1 & (s0 | alive);
+		}
+		else
+		{
+			const uint64_t low[4] {~(s1 | s0), s0 & ~s1, s1 & ~s0, s1 & s0};
+			const uint64_t high[3] {~(s3 | s2), s2, s3};
+			uint64_t born {};
+			uint64_t kept {};
+			[&]<uint32_t... n>(std::integer_sequence<uint32_t, n...>)
+			{
+				((born |= low[n & 3] & high[n >> 2] & rule.birth(n)), ...);
+				((kept |= low[n & 3] & high[n >> 2] & rule.survival(n)), ...);
+			}(std::make_integer_sequence<uint32_t, 9> {});
+			return (born & ~alive) | (kept & alive);
+		}
+	}
+	
+	// next state of 64 cells out of their eight neighbour words, top row, middle row without the cells themselves
+	// and bottom row, each row given as west, centre and east
+	template <typename Rule>
+	inline uint64_t evolve(const Rule & rule, uint64_t tw, uint64_t tc, uint64_t te, uint64_t mw, uint64_t mc, uint64_t me, uint64_t bw, uint64_t bc, uint64_t be)
+	{
+		uint64_t t0, t1, m0, m1, b0, b1;
+		full_add(tw, tc, te, t0, t1);
+		half_add(mw, me, m0, m1);
+		full_add(bw, bc, be, b0, b1);
+		// count = s0 + 2 * s1 + 4 * s2 + 8 * s3
+		uint64_t s0, s1, s2, s3, c1, c2, u0, u1;
+		full_add(t0, m0, b0, s0, c1);
+		full_add(t1, m1, b1, u0, u1);
+		half_add(u0, c1, s1, c2);
+		half_add(u1, c2, s2, s3);
+		return apply(rule, s0, s1, s2, s3, mc);
+	}
+	
+	// steps words [first, last) of a row, every one of them must have both neighbour words in the same row;
+	// returns the first word left for the caller because it does not fill a whole vector
+	using interior_kernel = uint32_t (*)(const uint64_t * top, const uint64_t * middle, const uint64_t * bottom, uint64_t * out, uint32_t first, uint32_t last, const table_rule & table);
+	// next state of word w at either end of a row, where neighbours wrap around
+	using edge_kernel = uint64_t (*)(const uint64_t * top, const uint64_t * middle, const uint64_t * bottom, uint32_t w, uint32_t stride, uint32_t width, const table_rule & table);
+	
+	// small worlds of a soup search side by side: a row of a world up to 64 cells wide is a single word,
+	// word y * soup_lanes + i holds row y of world i, so a vector steps as many worlds as it has lanes;
+	// every world wraps around within its own word
+	inline constexpr uint32_t soup_lanes {8};
+	
+	// neighbours to the west and east of the cells of a row of a world width cells wide, mask holds its cells
+	inline uint64_t soup_west(uint64_t row, uint32_t width, uint64_t mask)
+	{
+		return ((row << 1) | (row >> (width - 1))) & mask;
+	}
+	
+	inline uint64_t soup_east(uint64_t row, uint32_t width)
+	{
+		return (row >> 1) | ((row & 1) << (width - 1));
+	}
+	
+	// steps all soup_lanes worlds of the given size packed as above from src into dst
+	using soup_kernel = void (*)(const uint64_t * src, uint64_t * dst, uint32_t width, uint32_t height, const table_rule & table);
+	
+	// next generation by a rule: kernels are picked once for the host and the rule, so stepping looks at neither
+	class kernel
+	{
+	public:
+		kernel();
+		explicit kernel(const game::rule & r);
+		const game::rule & rule() const { return m_rule; }
+		// computes rows [first, last) of the next generation of src into dst;
+		// both grids must have the same size, the world wraps around at all the edges
+		void step(const grid & src, grid & dst, uint32_t first, uint32_t last) const;
+		// same for words [first, last) of a single row y
+		void step_span(const grid & src, grid & dst, uint32_t y, uint32_t first, uint32_t last) const;
+		// steps packed worlds of a soup search, see game::soup_lanes; width is from 1 to 64
+		void step_soups(const uint64_t * src, uint64_t * dst, uint32_t width, uint32_t height) const;
+	private:
+		game::rule m_rule;
+		table_rule m_table;											// masks of rules played through a table
+		interior_kernel m_vector;									// widest instructions of the host
+		interior_kernel m_scalar;									// words left over by them
+		edge_kernel m_edge;											// words at the ends of rows
+		soup_kernel m_soups;
+	};
+	
+	// what changes when words [first, last) of row y go from before to after: the hash of the grid,
+	// the cells born and the cells that died
+	changes compare(const grid & before, const grid & after, uint32_t y, uint32_t first, uint32_t last);
+	
+	// row of a world played by a Generations rule: dying cells have an age from 1 to states - 2 kept in binary
+	// over bit planes, 0 for living and dead cells, so a cell takes 2 to 4 bits with its living bit
+	struct dying_row
+	{
+		const uint64_t * before;									// living cells of the generation before
+		uint64_t * after;											// living cells as the life-like kernel left them
+		uint64_t * planes[3];										// bits of the ages, lowest first
+		uint32_t count;												// planes in use
+		uint32_t expiry;											// age a cell is dead at, cut to the bits of the planes
+		uint64_t index;												// index of word 0 of the row in a plane
+		uint64_t size;												// words of a plane
+	};
+	
+	// ages dying cells of words [first, last) of a row by one generation and starts the ones living cells left,
+	// cells still dying are not born again; XORs word_hash() of every plane word before and after into hash,
+	// word w of plane i taken at index + (i + 1) * size + w, so planes never share keys with the living cells;
+	// returns the first word left for the caller the same way as the interior kernels
+	using decay_kernel = uint32_t (*)(const dying_row & row, uint32_t first, uint32_t last, uint64_t & hash);
+	// same for the whole of words [first, last), returns the hash
+	uint64_t fade(const dying_row & row, uint32_t first, uint32_t last);
+	
+	// dying cells of one word: ages in the planes of the row are moved on, cells with the expiry age are dead,
+	// then the living cells that did not survive start with age 1
+	template <uint32_t planes>
+	inline void fade_word(const dying_row & row, uint32_t w, uint64_t & hash)
+	{
+		uint64_t d[planes];
+		uint64_t dying {};
+		for (uint32_t i {}; i < planes; ++i)
+		{
+			d[i] = row.planes[i][w];
+			dying |= d[i];
+			hash ^= word_hash(row.index + (i + 1) * row.size + w, d[i]);
+		}
+		const uint64_t alive {row.after[w] & ~dying};
+		const uint64_t started {row.before[w] & ~alive};
+		// age + 1 in every dying cell, carries go from plane to plane
+		uint64_t carry {dying};
+		uint64_t expired {dying};
+		for (uint32_t i {}; i < planes; ++i)
+		{
+			const uint64_t next {d[i] & carry};
+			d[i] ^= carry;
+			carry = next;
+			expired &= (row.expiry >> i) & 1 ? d[i] : ~d[i];
+		}
+		for (uint32_t i {}; i < planes; ++i)
+		{
+			d[i] = (d[i] & ~expired) | (i == 0 ? started : 0);
+			row.planes[i][w] = d[i];
+			hash ^= word_hash(row.index + (i + 1) * row.size + w, d[i]);
+		}
+		row.after[w] = alive;
+	}
+	
+	// instruction set the kernel has chosen for this host: "avx512", "avx2" or "scalar"
+	std::string_view step_isa();
+}
@@ -0,0 +1,301 @@
+//
+//  kernel_avx2.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "kernel_simd.h"
+#include <immintrin.h>
+#include <bit>
+
+GAME_TARGET_BEGIN("avx2")
+
+// same adder network and rules as game::evolve() in kernel.h, 4 words (256 cells) at a time
+
+namespace
+{
+	inline void half_add(__m256i a, __m256i b, __m256i & sum, __m256i & carry)
+	{
+		sum = _mm256_xor_si256(a, b);
+		carry = _mm256_and_si256(a, b);
+	}
+	
+	inline void full_add(__m256i a, __m256i b, __m256i c, __m256i & sum, __m256i & carry)
+	{
+		const __m256i t {_mm256_xor_si256(a, b)};
+		sum = _mm256_xor_si256(t, c);
+		carry = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(t, c));
+	}
+	
+	inline __m256i west(const uint64_t * row)
+	{
+		return _mm256_or_si256(_mm256_slli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row)), 1),
+		                       _mm256_srli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row - 1)), 63));
+	}
+	
+	inline __m256i east(const uint64_t * row)
+	{
+		return _mm256_or_si256(_mm256_srli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row)), 1),
+		                       _mm256_slli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + 1)), 63));
+	}
+	
+	// masks of the rule as vectors: constants for fixed rules, broadcast once before the loop for a table
+	template <typename Rule>
+	struct vector_rule
+	{
+		explicit vector_rule(const game::table_rule &)
+		{
+			
+		}
+		
+		static __m256i birth(uint32_t n) { return _mm256_set1_epi64x(static_cast<long long>(Rule::birth(n))); }
+		static __m256i survival(uint32_t n) { return _mm256_set1_epi64x(static_cast<long long>(Rule::survival(n))); }
+	};
+	
+	template <>
+	struct vector_rule<game::table_rule>
+	{
+		explicit vector_rule(const game::table_rule & table)
+		{
+			for (uint32_t n {}; n < 9; ++n)
+			{
+				births[n] = _mm256_set1_epi64x(static_cast<long long>(table.births[n]));
+				survivals[n] = _mm256_set1_epi64x(static_cast<long long>(table.survivals[n]));
+			}
+		}
+		
+		__m256i birth(uint32_t n) const { return births[n]; }
+		__m256i survival(uint32_t n) const { return survivals[n]; }
+		__m256i births[9];
+		__m256i survivals[9];
+	};
+	
+	// same as game::apply()
+	template <typename Rule>
+	inline __m256i apply(const vector_rule<Rule> & rule, __m256i s0, __m256i s1, __m256i s2, __m256i s3, __m256i alive)
+	{
+		if constexpr (std::is_same_v<Rule, game::fixed_rule<game::conway>>)
+		{
+			// ~s3 & ~s2 & s1 & (s0 | alive)
+			return _mm256_andnot_si256(_mm256_or_si256(s3, s2), _mm256_and_si256(s1, _mm256_or_si256(s0, alive)));
+		}
+		else
+		{
+			const __m256i ones {_mm256_set1_epi64x(-1)};
+			const __m256i low[4] {_mm256_andnot_si256(_mm256_or_si256(s1, s0), ones), _mm256_andnot_si256(s1, s0),
+			                      _mm256_andnot_si256(s0, s1), _mm256_and_si256(s1, s0)};
+			const __m256i high[3] {_mm256_andnot_si256(_mm256_or_si256(s3, s2), ones), s2, s3};
+			__m256i born {_mm256_setzero_si256()};
+			__m256i kept {_mm256_setzero_si256()};
+			[&]<uint32_t... n>(std::integer_sequence<uint32_t, n...>)
+			{
+				((born = _mm256_or_si256(born, _mm256_and_si256(_mm256_and_si256(low[n & 3], high[n >> 2]), rule.birth(n)))), ...);
+				((kept = _mm256_or_si256(kept, _mm256_and_si256(_mm256_and_si256(low[n & 3], high[n >> 2]), rule.survival(n)))), ...);
+			}(std::make_integer_sequence<uint32_t, 9> {});
+			return _mm256_or_si256(_mm256_andnot_si256(alive, born), _mm256_and_si256(kept, alive));
+		}
+	}
+	
+	// next state of the cells out of their neighbours, same as game::evolve()
+	template <typename Rule>
+	inline __m256i evolve(const vector_rule<Rule> & rule, __m256i tw, __m256i tc, __m256i te, __m256i mw, __m256i mc, __m256i me, __m256i bw, __m256i bc, __m256i be)
+	{
+		__m256i t0, t1, m0, m1, b0, b1;
+		full_add(tw, tc, te, t0, t1);
+		half_add(mw, me, m0, m1);
+		full_add(bw, bc, be, b0, b1);
+		__m256i s0, s1, s2, s3, c1, c2, u0, u1;
+		full_add(t0, m0, b0, s0, c1);
+		full_add(t1, m1, b1, u0, u1);
+		half_add(u0, c1, s1, c2);
+		half_add(u1, c2, s2, s3);
+		return apply(rule, s0, s1, s2, s3, mc);
+	}
+	
+	template <typename Rule>
+	uint32_t step_interior(const uint64_t * top, const uint64_t * middle, const uint64_t * bottom, uint64_t * out, uint32_t first, uint32_t last, const game::table_rule & table)
+	{
+		const vector_rule<Rule> rule {table};
+		uint32_t w {first};
+		for (; w + 4 <= last; w += 4)
+		{
+			const __m256i next {evolve(rule, west(top + w), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(top + w)), east(top + w),
+			                                 west(middle + w), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(middle + w)), east(middle + w),
+			                                 west(bottom + w), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bottom + w)), east(bottom + w))};
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + w), next);
+		}
+		return w;
+	}
+	
+	// soup worlds of 4 lanes at a time, see game::soup_kernel; shifts by the width take their count from a register
+	template <typename Rule>
+	void step_soups(const uint64_t * src, uint64_t * dst, uint32_t width, uint32_t height, const game::table_rule & table)
+	{
+		const vector_rule<Rule> rule {table};
+		const __m256i mask {_mm256_set1_epi64x(width == 64 ? -1 : static_cast<long long>((uint64_t {1} << width) - 1))};
+		const __m256i one {_mm256_set1_epi64x(1)};
+		const __m128i last {_mm_cvtsi32_si128(static_cast<int>(width - 1))};
+		__m256i w[3], c[3], e[3];
+		for (uint32_t y {}; y < height; ++y)
+		{
+			const uint64_t * rows[3] {src + static_cast<std::size_t>((y + height - 1) % height) * game::soup_lanes,
+			                          src + static_cast<std::size_t>(y) * game::soup_lanes,
+			                          src + static_cast<std::size_t>((y + 1) % height) * game::soup_lanes};
+			for (uint32_t i {}; i < game::soup_lanes; i += 4)
+			{
+				for (uint32_t j {}; j < 3; ++j)
+				{
+					c[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[j] + i));
+					w[j] = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi64(c[j], 1), _mm256_srl_epi64(c[j], last)), mask);
+					e[j] = _mm256_or_si256(_mm256_srli_epi64(c[j], 1), _mm256_sll_epi64(_mm256_and_si256(c[j], one), last));
+				}
+				const __m256i next {evolve(rule, w[0], c[0], e[0], w[1], c[1], e[1], w[2], c[2], e[2])};
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + static_cast<std::size_t>(y) * game::soup_lanes + i), _mm256_and_si256(next, mask));
+			}
+		}
+	}
+	
+	inline __m256i word_hash(__m256i word, __m256i keys)
+	{
+		const __m256i h {_mm256_xor_si256(word, keys)};
+		return _mm256_xor_si256(_mm256_mul_epu32(h, _mm256_set1_epi64x(static_cast<long long>(game::hash_low))),
+		                        _mm256_mul_epu32(_mm256_srli_epi64(h, 32), _mm256_set1_epi64x(static_cast<long long>(game::hash_high))));
+	}
+	
+	// same as game::fade_word() for 4 words at a time
+	template <uint32_t planes>
+	uint32_t step_decay(const game::dying_row & row, uint32_t first, uint32_t last, uint64_t & hash)
+	{
+		uint32_t w {first};
+		if (w + 4 > last)
+		{
+			return w;
+		}
+		// keys of the words in every plane, moved on by 4 words every time
+		alignas(32) uint64_t lanes[4];
+		__m256i keys[planes];
+		for (uint32_t i {}; i < planes; ++i)
+		{
+			for (uint64_t j {}; j < 4; ++j)
+			{
+				lanes[j] = (row.index + (i + 1) * row.size + w + j) * game::hash_index;
+			}
+			keys[i] = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes));
+		}
+		const __m256i step {_mm256_set1_epi64x(static_cast<long long>(4 * game::hash_index))};
+		__m256i sum {_mm256_setzero_si256()};
+		for (; w + 4 <= last; w += 4)
+		{
+			__m256i d[planes];
+			__m256i dying {_mm256_setzero_si256()};
+			for (uint32_t i {}; i < planes; ++i)
+			{
+				d[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row.planes[i] + w));
+				dying = _mm256_or_si256(dying, d[i]);
+				sum = _mm256_xor_si256(sum, word_hash(d[i], keys[i]));
+			}
+			const __m256i alive {_mm256_andnot_si256(dying, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row.after + w)))};
+			const __m256i started {_mm256_andnot_si256(alive, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row.before + w)))};
+			__m256i carry {dying};
+			__m256i expired {dying};
+			for (uint32_t i {}; i < planes; ++i)
+			{
+				const __m256i next {_mm256_and_si256(d[i], carry)};
+				d[i] = _mm256_xor_si256(d[i], carry);
+				carry = next;
+				expired = (row.expiry >> i) & 1 ? _mm256_and_si256(expired, d[i]) : _mm256_andnot_si256(d[i], expired);
+			}
+			for (uint32_t i {}; i < planes; ++i)
+			{
+				d[i] = _mm256_andnot_si256(expired, d[i]);
+				if (i == 0)
+				{
+					d[i] = _mm256_or_si256(d[i], started);
+				}
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(row.planes[i] + w), d[i]);
+				sum = _mm256_xor_si256(sum, word_hash(d[i], keys[i]));
+				keys[i] = _mm256_add_epi64(keys[i], step);
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(row.after + w), alive);
+		}
+		_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sum);
+		hash ^= lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3];
+		return w;
+	}
+}
+
+namespace game::simd
+{
+	interior_kernel interior_avx2(const rule & r)
+	{
+		return with_rule(r, []<typename Rule>(const Rule &) -> interior_kernel
+		{
+			return step_interior<Rule>;
+		});
+	}
+	
+	soup_kernel soups_avx2(const rule & r)
+	{
+		return with_rule(r, []<typename Rule>(const Rule &) -> soup_kernel
+		{
+			return step_soups<Rule>;
+		});
+	}
+	
+	// word_hash() of 4 words at a time, 32-bit multiplications give 64-bit products in every lane;
+	// there is no vector population count, so births and deaths are counted from the lanes
+	uint32_t compare_avx2(const uint64_t * before, const uint64_t * after, uint64_t index, uint32_t first, uint32_t last, changes & result)
+	{
+		uint32_t w {first};
+		if (w + 4 > last)
+		{
+			return w;
+		}
+		const __m256i low {_mm256_set1_epi64x(static_cast<long long>(hash_low))};
+		const __m256i high {_mm256_set1_epi64x(static_cast<long long>(hash_high))};
+		const __m256i step {_mm256_set1_epi64x(static_cast<long long>(4 * hash_index))};
+		// keys of consecutive words, moved on by 4 words every time
+		alignas(32) uint64_t lanes[4];
+		for (uint64_t i {}; i < 4; ++i)
+		{
+			lanes[i] = (index + w + i) * hash_index;
+		}
+		__m256i keys {_mm256_load_si256(reinterpret_cast<const __m256i *>(lanes))};
+		alignas(32) uint64_t born[4];
+		alignas(32) uint64_t died[4];
+		__m256i sum {_mm256_setzero_si256()};
+		for (; w + 4 <= last; w += 4)
+		{
+			const __m256i old {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(before + w))};
+			const __m256i now {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(after + w))};
+			_mm256_store_si256(reinterpret_cast<__m256i *>(born), _mm256_andnot_si256(old, now));
+			_mm256_store_si256(reinterpret_cast<__m256i *>(died), _mm256_andnot_si256(now, old));
+			for (uint32_t i {}; i < 4; ++i)
+			{
+				result.births += std::popcount(born[i]);
+				result.deaths += std::popcount(died[i]);
+			}
+			const __m256i b {_mm256_xor_si256(old, keys)};
+			const __m256i a {_mm256_xor_si256(now, keys)};
+			sum = _mm256_xor_si256(sum, _mm256_xor_si256(_mm256_mul_epu32(b, low), _mm256_mul_epu32(_mm256_srli_epi64(b, 32), high)));
+			sum = _mm256_xor_si256(sum, _mm256_xor_si256(_mm256_mul_epu32(a, low), _mm256_mul_epu32(_mm256_srli_epi64(a, 32), high)));
+			keys = _mm256_add_epi64(keys, step);
+		}
+		_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sum);
+		result.hash ^= lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3];
+		return w;
+	}
+	
+	decay_kernel decay_avx2(uint32_t planes)
+	{
+		switch (planes)
+		{
+			case 1: return step_decay<1>;
+			case 2: return step_decay<2>;
+			default: return step_decay<3>;
+		}
+	}
+}
+
+GAME_TARGET_END
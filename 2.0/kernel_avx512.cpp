@@ -0,0 +1,304 @@
+//
+//  kernel_avx512.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "kernel_simd.h"
+#include <immintrin.h>
+#include <bit>
+
+GAME_TARGET_BEGIN("avx512f")
+
+// same adder network and rules as game::evolve() in kernel.h, 8 words (512 cells) at a time;
+// ternary logic instructions fold every three-input boolean function into one instruction
+
+namespace
+{
+	inline void half_add(__m512i a, __m512i b, __m512i & sum, __m512i & carry)
+	{
+		sum = _mm512_xor_si512(a, b);
+		carry = _mm512_and_si512(a, b);
+	}
+	
+	inline void full_add(__m512i a, __m512i b, __m512i c, __m512i & sum, __m512i & carry)
+	{
+		// truth tables: 0x96 is a ^ b ^ c, 0xe8 is majority of a, b and c
+		sum = _mm512_ternarylogic_epi64(a, b, c, 0x96);
+		carry = _mm512_ternarylogic_epi64(a, b, c, 0xe8);
+	}
+	
+	inline __m512i west(const uint64_t * row)
+	{
+		return _mm512_or_si512(_mm512_slli_epi64(_mm512_loadu_si512(row), 1), _mm512_srli_epi64(_mm512_loadu_si512(row - 1), 63));
+	}
+	
+	inline __m512i east(const uint64_t * row)
+	{
+		return _mm512_or_si512(_mm512_srli_epi64(_mm512_loadu_si512(row), 1), _mm512_slli_epi64(_mm512_loadu_si512(row + 1), 63));
+	}
+	
+	// masks of the rule as vectors: constants for fixed rules, broadcast once before the loop for a table
+	template <typename Rule>
+	struct vector_rule
+	{
+		explicit vector_rule(const game::table_rule &)
+		{
+			
+		}
+		
+		static __m512i birth(uint32_t n) { return _mm512_set1_epi64(static_cast<long long>(Rule::birth(n))); }
+		static __m512i survival(uint32_t n) { return _mm512_set1_epi64(static_cast<long long>(Rule::survival(n))); }
+	};
+	
+	template <>
+	struct vector_rule<game::table_rule>
+	{
+		explicit vector_rule(const game::table_rule & table)
+		{
+			for (uint32_t n {}; n < 9; ++n)
+			{
+				births[n] = _mm512_set1_epi64(static_cast<long long>(table.births[n]));
+				survivals[n] = _mm512_set1_epi64(static_cast<long long>(table.survivals[n]));
+			}
+		}
+		
+		__m512i birth(uint32_t n) const { return births[n]; }
+		__m512i survival(uint32_t n) const { return survivals[n]; }
+		__m512i births[9];
+		__m512i survivals[9];
+	};
+	
+	// same as game::apply()
+	template <typename Rule>
+	inline __m512i apply(const vector_rule<Rule> & rule, __m512i s0, __m512i s1, __m512i s2, __m512i s3, __m512i alive)
+	{
+		if constexpr (std::is_same_v<Rule, game::fixed_rule<game::conway>>)
+		{
+			// ~s3 & ~s2 & s1 & (s0 | alive)
+			return _mm512_andnot_si512(_mm512_or_si512(s3, s2), _mm512_and_si512(s1, _mm512_or_si512(s0, alive)));
+		}
+		else
+		{
+			const __m512i ones {_mm512_set1_epi64(-1)};
+			const __m512i low[4] {_mm512_andnot_si512(_mm512_or_si512(s1, s0), ones), _mm512_andnot_si512(s1, s0),
+			                      _mm512_andnot_si512(s0, s1), _mm512_and_si512(s1, s0)};
+			const __m512i high[3] {_mm512_andnot_si512(_mm512_or_si512(s3, s2), ones), s2, s3};
+			__m512i born {_mm512_setzero_si512()};
+			__m512i kept {_mm512_setzero_si512()};
+			[&]<uint32_t... n>(std::integer_sequence<uint32_t, n...>)
+			{
+				((born = _mm512_or_si512(born, _mm512_and_si512(_mm512_and_si512(low[n & 3], high[n >> 2]), rule.birth(n)))), ...);
+				((kept = _mm512_or_si512(kept, _mm512_and_si512(_mm512_and_si512(low[n & 3], high[n >> 2]), rule.survival(n)))), ...);
+			}(std::make_integer_sequence<uint32_t, 9> {});
+			return _mm512_or_si512(_mm512_andnot_si512(alive, born), _mm512_and_si512(kept, alive));
+		}
+	}
+	
+	// next state of the cells out of their neighbours, same as game::evolve()
+	template <typename Rule>
+	inline __m512i evolve(const vector_rule<Rule> & rule, __m512i tw, __m512i tc, __m512i te, __m512i mw, __m512i mc, __m512i me, __m512i bw, __m512i bc, __m512i be)
+	{
+		__m512i t0, t1, m0, m1, b0, b1;
+		full_add(tw, tc, te, t0, t1);
+		half_add(mw, me, m0, m1);
+		full_add(bw, bc, be, b0, b1);
+		__m512i s0, s1, s2, s3, c1, c2, u0, u1;
+		full_add(t0, m0, b0, s0, c1);
+		full_add(t1, m1, b1, u0, u1);
+		half_add(u0, c1, s1, c2);
+		half_add(u1, c2, s2, s3);
+		return apply(rule, s0, s1, s2, s3, mc);
+	}
+	
+	template <typename Rule>
+	uint32_t step_interior(const uint64_t * top, const uint64_t * middle, const uint64_t * bottom, uint64_t * out, uint32_t first, uint32_t last, const game::table_rule & table)
+	{
+		const vector_rule<Rule> rule {table};
+		uint32_t w {first};
+		for (; w + 8 <= last; w += 8)
+		{
+			const __m512i next {evolve(rule, west(top + w), _mm512_loadu_si512(top + w), east(top + w),
+			                                 west(middle + w), _mm512_loadu_si512(middle + w), east(middle + w),
+			                                 west(bottom + w), _mm512_loadu_si512(bottom + w), east(bottom + w))};
+			_mm512_storeu_si512(out + w, next);
+		}
+		return w;
+	}
+	
+	// soup worlds of 8 lanes at a time, see game::soup_kernel; shifts by the width take their count from a register
+	template <typename Rule>
+	void step_soups(const uint64_t * src, uint64_t * dst, uint32_t width, uint32_t height, const game::table_rule & table)
+	{
+		const vector_rule<Rule> rule {table};
+		const __m512i mask {_mm512_set1_epi64(width == 64 ? -1 : static_cast<long long>((uint64_t {1} << width) - 1))};
+		const __m512i one {_mm512_set1_epi64(1)};
+		const __m128i last {_mm_cvtsi32_si128(static_cast<int>(width - 1))};
+		__m512i w[3], c[3], e[3];
+		for (uint32_t y {}; y < height; ++y)
+		{
+			const uint64_t * rows[3] {src + static_cast<std::size_t>((y + height - 1) % height) * game::soup_lanes,
+			                          src + static_cast<std::size_t>(y) * game::soup_lanes,
+			                          src + static_cast<std::size_t>((y + 1) % height) * game::soup_lanes};
+			for (uint32_t i {}; i < game::soup_lanes; i += 8)
+			{
+				for (uint32_t j {}; j < 3; ++j)
+				{
+					c[j] = _mm512_loadu_si512(rows[j] + i);
+					w[j] = _mm512_and_si512(_mm512_or_si512(_mm512_slli_epi64(c[j], 1), _mm512_srl_epi64(c[j], last)), mask);
+					e[j] = _mm512_or_si512(_mm512_srli_epi64(c[j], 1), _mm512_sll_epi64(_mm512_and_si512(c[j], one), last));
+				}
+				const __m512i next {evolve(rule, w[0], c[0], e[0], w[1], c[1], e[1], w[2], c[2], e[2])};
+				_mm512_storeu_si512(dst + static_cast<std::size_t>(y) * game::soup_lanes + i, _mm512_and_si512(next, mask));
+			}
+		}
+	}
+	
+	inline __m512i word_hash(__m512i word, __m512i keys)
+	{
+		const __m512i h {_mm512_xor_si512(word, keys)};
+		return _mm512_xor_si512(_mm512_mul_epu32(h, _mm512_set1_epi64(static_cast<long long>(game::hash_low))),
+		                        _mm512_mul_epu32(_mm512_srli_epi64(h, 32), _mm512_set1_epi64(static_cast<long long>(game::hash_high))));
+	}
+	
+	// same as game::fade_word() for 8 words at a time
+	template <uint32_t planes>
+	uint32_t step_decay(const game::dying_row & row, uint32_t first, uint32_t last, uint64_t & hash)
+	{
+		uint32_t w {first};
+		if (w + 8 > last)
+		{
+			return w;
+		}
+		// keys of the words in every plane, moved on by 8 words every time
+		alignas(64) uint64_t lanes[8];
+		__m512i keys[planes];
+		for (uint32_t i {}; i < planes; ++i)
+		{
+			for (uint64_t j {}; j < 8; ++j)
+			{
+				lanes[j] = (row.index + (i + 1) * row.size + w + j) * game::hash_index;
+			}
+			keys[i] = _mm512_load_si512(lanes);
+		}
+		const __m512i step {_mm512_set1_epi64(static_cast<long long>(8 * game::hash_index))};
+		__m512i sum {_mm512_setzero_si512()};
+		for (; w + 8 <= last; w += 8)
+		{
+			__m512i d[planes];
+			__m512i dying {_mm512_setzero_si512()};
+			for (uint32_t i {}; i < planes; ++i)
+			{
+				d[i] = _mm512_loadu_si512(row.planes[i] + w);
+				dying = _mm512_or_si512(dying, d[i]);
+				sum = _mm512_xor_si512(sum, word_hash(d[i], keys[i]));
+			}
+			const __m512i alive {_mm512_andnot_si512(dying, _mm512_loadu_si512(row.after + w))};
+			const __m512i started {_mm512_andnot_si512(alive, _mm512_loadu_si512(row.before + w))};
+			__m512i carry {dying};
+			__m512i expired {dying};
+			for (uint32_t i {}; i < planes; ++i)
+			{
+				const __m512i next {_mm512_and_si512(d[i], carry)};
+				d[i] = _mm512_xor_si512(d[i], carry);
+				carry = next;
+				expired = (row.expiry >> i) & 1 ? _mm512_and_si512(expired, d[i]) : _mm512_andnot_si512(d[i], expired);
+			}
+			for (uint32_t i {}; i < planes; ++i)
+			{
+				// 0xba is (d & ~expired) | started
+				d[i] = i == 0 ? _mm512_ternarylogic_epi64(d[i], expired, started, 0xba)
+				              : _mm512_andnot_si512(expired, d[i]);
+				_mm512_storeu_si512(row.planes[i] + w, d[i]);
+				sum = _mm512_xor_si512(sum, word_hash(d[i], keys[i]));
+				keys[i] = _mm512_add_epi64(keys[i], step);
+			}
+			_mm512_storeu_si512(row.after + w, alive);
+		}
+		_mm512_store_si512(lanes, sum);
+		for (uint64_t value : lanes)
+		{
+			hash ^= value;
+		}
+		return w;
+	}
+}
+
+namespace game::simd
+{
+	interior_kernel interior_avx512(const rule & r)
+	{
+		return with_rule(r, []<typename Rule>(const Rule &) -> interior_kernel
+		{
+			return step_interior<Rule>;
+		});
+	}
+	
+	soup_kernel soups_avx512(const rule & r)
+	{
+		return with_rule(r, []<typename Rule>(const Rule &) -> soup_kernel
+		{
+			return step_soups<Rule>;
+		});
+	}
+	
+	uint32_t compare_avx512(const uint64_t * before, const uint64_t * after, uint64_t index, uint32_t first, uint32_t last, changes & result)
+	{
+		uint32_t w {first};
+		if (w + 8 > last)
+		{
+			return w;
+		}
+		const __m512i low {_mm512_set1_epi64(static_cast<long long>(hash_low))};
+		const __m512i high {_mm512_set1_epi64(static_cast<long long>(hash_high))};
+		const __m512i step {_mm512_set1_epi64(static_cast<long long>(8 * hash_index))};
+		// keys of consecutive words, moved on by 8 words every time
+		alignas(64) uint64_t lanes[8];
+		for (uint64_t i {}; i < 8; ++i)
+		{
+			lanes[i] = (index + w + i) * hash_index;
+		}
+		__m512i keys {_mm512_load_si512(lanes)};
+		// population count of vectors needs AVX512VPOPCNTDQ, which AVX-512F does not promise
+		alignas(64) uint64_t born[8];
+		alignas(64) uint64_t died[8];
+		__m512i sum {_mm512_setzero_si512()};
+		for (; w + 8 <= last; w += 8)
+		{
+			const __m512i old {_mm512_loadu_si512(before + w)};
+			const __m512i now {_mm512_loadu_si512(after + w)};
+			_mm512_store_si512(born, _mm512_andnot_si512(old, now));
+			_mm512_store_si512(died, _mm512_andnot_si512(now, old));
+			for (uint32_t i {}; i < 8; ++i)
+			{
+				result.births += std::popcount(born[i]);
+				result.deaths += std::popcount(died[i]);
+			}
+			const __m512i b {_mm512_xor_si512(old, keys)};
+			const __m512i a {_mm512_xor_si512(now, keys)};
+			// 0x96 folds the three XORs of every pair into one instruction
+			sum = _mm512_ternarylogic_epi64(sum, _mm512_mul_epu32(b, low), _mm512_mul_epu32(_mm512_srli_epi64(b, 32), high), 0x96);
+			sum = _mm512_ternarylogic_epi64(sum, _mm512_mul_epu32(a, low), _mm512_mul_epu32(_mm512_srli_epi64(a, 32), high), 0x96);
+			keys = _mm512_add_epi64(keys, step);
+		}
+		_mm512_store_si512(lanes, sum);
+		for (uint64_t value : lanes)
+		{
+			result.hash ^= value;
+		}
+		return w;
+	}
+	
+	decay_kernel decay_avx512(uint32_t planes)
+	{
+		switch (planes)
+		{
+			case 1: return step_decay<1>;
+			case 2: return step_decay<2>;
+			default: return step_decay<3>;
+		}
+	}
+}
+
+GAME_TARGET_END
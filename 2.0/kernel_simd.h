@@ -0,0 +1,52 @@
+//
+//  kernel_simd.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "kernel.h"
+#include <cstdint>
+
+// vector versions of the step kernel, each one lives in its own translation unit
+// built for its instruction set and is only called when the host supports it
+
+// the code of such a unit goes between GAME_TARGET_BEGIN and GAME_TARGET_END, after all includes: inline functions
+// of the headers are built in every unit using them and the linker keeps any one copy, so they must stay
+// without the instruction set; MSVC builds intrinsics of any instruction set as is
+#if defined(__clang__)
+#define GAME_PRAGMA(text) _Pragma(#text)
+#define GAME_TARGET_BEGIN(isa) GAME_PRAGMA(clang attribute push (__attribute__((target(isa))), apply_to = function))
+#define GAME_TARGET_END GAME_PRAGMA(clang attribute pop)
+#elif defined(__GNUC__)
+#define GAME_PRAGMA(text) _Pragma(#text)
+#define GAME_TARGET_BEGIN(isa) GAME_PRAGMA(GCC push_options) GAME_PRAGMA(GCC target(isa))
+#define GAME_TARGET_END GAME_PRAGMA(GCC pop_options)
+#else
+#define GAME_TARGET_BEGIN(isa)
+#define GAME_TARGET_END
+#endif
+
+namespace game::simd
+{
+	// adds what changes in words [first, last) of a row to result: XOR of word_hash() of both rows, births and deaths,
+	// index is the one of word 0 in the grid; returns the first word left for the caller the same way
+	using compare_kernel = uint32_t (*)(const uint64_t * before, const uint64_t * after, uint64_t index, uint32_t first, uint32_t last, changes & result);
+
+#ifdef GAME_SIMD_X86
+	bool has_avx2();
+	bool has_avx512();
+	// interior kernels made for the rule, see game::interior_kernel
+	interior_kernel interior_avx2(const rule & r);
+	interior_kernel interior_avx512(const rule & r);
+	uint32_t compare_avx2(const uint64_t * before, const uint64_t * after, uint64_t index, uint32_t first, uint32_t last, changes & result);
+	uint32_t compare_avx512(const uint64_t * before, const uint64_t * after, uint64_t index, uint32_t first, uint32_t last, changes & result);
+	// soup kernels made for the rule, see game::soup_kernel
+	soup_kernel soups_avx2(const rule & r);
+	soup_kernel soups_avx512(const rule & r);
+	// decay kernels for the number of planes, see game::decay_kernel
+	decay_kernel decay_avx2(uint32_t planes);
+	decay_kernel decay_avx512(uint32_t planes);
+#endif
+}
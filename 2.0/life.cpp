@@ -6,7 +6,14 @@
 //
 
 #include "life.h"
-#include <random>
+#include "sparse.h"
+#include "hashlife.h"
+#include "search.h"
+#include "patterns.h"
+#include "mapped_file.h"
+#include "kernel.h"
+#include "generator.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -16,18 +23,6 @@
 //                 ESC[2J - erase entire screen
 //                 ESC[0m ... ESC[38m - change colour of output character
 
-// std::formatter specialization for colour class
-// must be defined out of game namespace
-template <>
-struct std::formatter<game::life::colour> : std::formatter<std::string_view>
-{
-	template <typename T>
-	auto format(game::life::colour c, T & t)
-	{
-		return std::formatter<std::string_view>::format("\u001b[" + std::to_string(static_cast<uint32_t>(c)) + "m", t);
-	}
-};
-
 // print() function from C++23 to interact with std::format;
 // will be replaced with std::print() later when C++23 comes
 constexpr void print(const std::string_view string, auto && ... args)
@@ -35,34 +30,79 @@ constexpr void print(const std::string_view string, auto && ... args)
 	fputs(std::vformat(string, std::make_format_args(args...)).c_str(), stdout);
 }
 
-namespace game
+namespace
 {
-	life::colour operator ++ (life::colour & c)
+	// duration in the unit that keeps it short, as 750ns, 12.3us or 4.5ms
+	std::string short_time(std::chrono::nanoseconds time)
 	{
-		uint32_t n {static_cast<uint32_t>(c)};
-		return (n == 37 ? c = life::colour::BLACK : c = static_cast<life::colour>(n + 1));
-	}
-	
-	bool operator == (life::colour lhs, life::colour rhs)
-	{
-		return static_cast<uint32_t>(lhs) == static_cast<uint32_t>(rhs);
+		const double count {static_cast<double>(time.count())};
+		if (count < 1e3)
+		{
+			return std::format("{:.0f}ns", count);
+		}
+		if (count < 1e6)
+		{
+			return std::format("{:.1f}us", count / 1e3);
+		}
+		if (count < 1e9)
+		{
+			return std::format("{:.1f}ms", count / 1e6);
+		}
+		return std::format("{:.1f}s", count / 1e9);
 	}
-	
-	life::cell::cell() : dead(colour::BLACK), alive(colour::CYAN), symbol("██")
+}
+
+namespace game
+{
+	life::cell::cell() : dead(colour::BLACK), alive(colour::CYAN)
 	{
 		
 	}
 	
-	life::life() : m_hold(false),
-	               m_quit(false),
-	               m_cell(),
-	               m_layout(layout::RANDOM),
-	               m_coord(),
-	               m_alive_cells(),
-	               m_generations(1),
-	               m_sleeping_time(500)
+	life::life(const settings & options) : m_hold(false),
+	                                       m_quit(false),
+	                                       m_cell(),
+	                                       m_layout(layout::RANDOM),
+	                                       m_coord(),
+	                                       m_size({options.width, options.height}),
+	                                       m_rules(options.rules),
+	                                       m_density(options.density),
+	                                       m_seed(options.seed),
+	                                       m_world_seed(),
+	                                       m_alive_cells(),
+	                                       m_births(),
+	                                       m_deaths(),
+	                                       m_generations(1),
+	                                       m_first_generation(1),
+	                                       m_redraw(true),
+	                                       m_view(),
+	                                       m_generation_time(options.rate == 0 ? std::chrono::nanoseconds {} : std::chrono::nanoseconds {std::chrono::seconds {1}} / options.rate),
+	                                       m_frame_time(std::chrono::nanoseconds {std::chrono::seconds {1}} / options.fps),
+	                                       m_newest(),
+	                                       m_kernel(),
+	                                       m_rule(rule_name(conway)),
+	                                       m_workers(options.threads),
+	                                       m_changes(m_workers.size()),
+	                                       m_hash(),
+	                                       m_history(options.period),
+	                                       m_candidate(),
+	                                       m_cycle(),
+	                                       m_hud(false),
+	                                       m_timings_file(options.timings),
+	                                       m_format(options.format)
 	{
-		
+		if (options.mode == engine::HASHLIFE)
+		{
+			m_universe = std::make_unique<hashlife>(options.step_exponent, options.cache_megabytes << 20);
+		}
+		else if (options.mode == engine::SPARSE)
+		{
+			m_universe = std::make_unique<sparse>();
+		}
+		if (!options.checkpoint.empty())
+		{
+			m_checkpoint = std::make_unique<checkpoint>(options.checkpoint, std::chrono::seconds {options.interval});
+		}
 	}
 	
 	life::~life()
@@ -70,8 +110,27 @@ namespace game
 		{
 			std::lock_guard<std::mutex> lk(m_mutex);
 			m_quit = true;
+			m_hold = false;
+		}
+		m_interaction.notify_one();
+		const bool played {m_update_thread.joinable()};
+		if (m_update_thread.joinable())
+		{
+			m_update_thread.join();
+		}
+		if (m_render_thread.joinable())
+		{
+			m_render_thread.join();
+		}
+		// game is resumed where it was left, not at the last checkpoint
+		if (m_checkpoint && played)
+		{
+			m_checkpoint->save(world(0), m_dying, m_generations, m_rule);
+		}
+		if (!m_timings_file.empty() && !m_timings.write(m_timings_file, m_format))
+		{
+			print("Could not write \"{}\"\n", m_timings_file);
 		}
-		m_update_thread.join();
 	}
 
 	void life::begin()
@@ -84,7 +143,7 @@ namespace game
 			print(std::format("{0}{1}{2}{3}\n: ",
 							  "[1] Generate random configuration\n",
 							  "[2] Load preset configuration\n",
-							  "[3] Read .txt file\n",
+							  "[3] Read pattern or snapshot file\n",
 							  "[X] Exit\n"));
 			std::getline(std::cin, input);
 			if (!std::cin)
@@ -149,143 +208,521 @@ namespace game
 		}
 	}
 	
+	void life::begin(uint32_t preset)
+	{
+		m_layout = static_cast<layout>(preset);
+		run();
+	}
+	
 	void life::run()
 	{
 		write_layout();
 		read_layout();
-		// launch game output and update in a separate thread
+		publish(outcome::RUNNING);
+		// update and output run in separate threads at their own rates: update thread publishes generations it computes
+		// and never waits for the terminal, render thread draws the latest one and skips those it missed
 		m_update_thread = std::thread {[this]()
 			{
-				// insert all output data to string before printing to avoid screen flickering on windows
-				std::string output_string;
-				while (true)
+				// generations are due at fixed steps from each other, so time spent computing them does not add up;
+				// every generation stays for a while, the first one included
+				auto deadline {std::chrono::steady_clock::now()};
+				while (!m_quit)
 				{
 					{
-						std::lock_guard<std::mutex> lk(m_mutex);
-						print("\u001b[2J\u001b[H");
-						for (uint32_t y {}; y < m_coord.Y; ++y)
+						std::unique_lock<std::mutex> lk(m_mutex);
+						const std::chrono::nanoseconds period {m_generation_time};
+						deadline += period;
+						// a generation late by more than a period is not caught up with, the schedule starts again from now
+						if (std::chrono::steady_clock::now() > deadline + period)
 						{
-							for (uint32_t x {}; x < m_coord.X; ++x)
-							{
-								if (m_worlds.back().at(y * m_coord.X + x))
-								{
-									std::format_to(std::back_inserter(output_string), "{}{}", m_cell.alive, m_cell.symbol);
-								}
-								else
-								{
-									std::format_to(std::back_inserter(output_string), "{}{}", m_cell.dead, m_cell.symbol);
-								}
-							}
-							std::format_to(std::back_inserter(output_string), "\n");
+							deadline = std::chrono::steady_clock::now();
+						}
+						// new speed takes effect at once instead of after the old period
+						else if (m_interaction.wait_until(lk, deadline, [this, period]() -> bool
+						{
+							return m_quit || m_generation_time != period;
+						}))
+						{
+							deadline = std::chrono::steady_clock::now();
+							continue;
 						}
-						print("{}{}", output_string, colour::DEFAULT);
-						output_string.clear();
 					}
 					update();
 					if (m_hold)
 					{
-						print(": ");
 						std::unique_lock<std::mutex> lk(m_mutex);
 						m_interaction.wait(lk, [this]() -> bool
 						{
 							return !m_hold;
 						});
-					}
-					if (m_quit)
-					{
-						break;
+						deadline = std::chrono::steady_clock::now();
 					}
 				}
 			}};
+		m_render_thread = std::thread {&life::render, this};
 		ingame_user_input();
 	}
 	
 	void life::end()
 	{
 		m_quit = true;
-		if (m_hold)
+		m_hold = false;
+		m_interaction.notify_one();
+	}
+	
+	bool life::benchmark(const settings & options)
+	{
+		if (!options.filename.empty())
 		{
-			m_hold = false;
-			m_interaction.notify_one();
+			if (!read_file(options.filename))
+			{
+				return false;
+			}
+		}
+		else if (options.preset != 0)
+		{
+			m_layout = static_cast<layout>(options.preset);
+		}
+		write_layout();
+		read_layout();
+		// end states are not checked, the engine keeps going for all the generations asked for
+		uint64_t generations {};
+		uint64_t births {};
+		uint64_t deaths {};
+		const auto start {std::chrono::steady_clock::now()};
+		while (generations < options.generations)
+		{
+			const auto time {std::chrono::steady_clock::now()};
+			advance();
+			m_timings.add(phase::STEP, time);
+			generations += m_universe ? m_universe->step() : 1;
+			births += m_births;
+			deaths += m_deaths;
+		}
+		const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+		const double seconds {std::max(elapsed.count(), 1e-9)};
+		const double cells {static_cast<double>(m_coord.X) * m_coord.Y * generations};
+		if (options.format == report::CSV)
+		{
+			print("engine,isa,threads,width,height,generations,seconds,generations_per_second,cells_per_second,population,births,deaths,seed\n");
+			print("{},{},{},{},{},{},{:.6f},{:.1f},{:.1f},{},{},{},{}\n", engine_name(options.mode), step_isa(), m_workers.size(),
+			      m_coord.X, m_coord.Y, generations, seconds, generations / seconds, cells / seconds, m_alive_cells, births, deaths,
+			      m_world_seed ? std::to_string(*m_world_seed) : std::string {});
+		}
+		else
+		{
+			print("{{\"engine\": \"{}\", \"isa\": \"{}\", \"threads\": {}, \"width\": {}, \"height\": {}, \"generations\": {}, "
+			      "\"seconds\": {:.6f}, \"generations_per_second\": {:.1f}, \"cells_per_second\": {:.1f}, \"population\": {}, "
+			      "\"births\": {}, \"deaths\": {}, \"seed\": {}}}\n",
+			      engine_name(options.mode), step_isa(), m_workers.size(), m_coord.X, m_coord.Y, generations,
+			      seconds, generations / seconds, cells / seconds, m_alive_cells, births, deaths,
+			      m_world_seed ? std::to_string(*m_world_seed) : std::string {"null"});
 		}
+		return true;
 	}
 	
-	void life::update()
+	void life::search(const settings & options)
 	{
+		const auto start {std::chrono::steady_clock::now()};
+		const search_results results {game::search(options, m_workers)};
+		const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+		const double seconds {std::max(elapsed.count(), 1e-9)};
+		const uint32_t width {options.width != 0 ? options.width : 16};
+		const uint32_t height {options.height != 0 ? options.height : 16};
+		const uint64_t settled {results.soups - results.extinct - results.capped};
+		// histograms list only the buckets holding soups, as ranges of values
+		auto from {[](std::size_t bucket) -> uint64_t
+			{
+				return bucket == 0 ? 0 : uint64_t {1} << (bucket - 1);
+			}};
+		auto to {[](std::size_t bucket) -> uint64_t
+			{
+				return bucket == 0 ? 0 : (uint64_t {1} << (bucket - 1)) * 2 - 1;
+			}};
+		if (options.format == report::CSV)
 		{
-			std::lock_guard<std::mutex> lk (m_mutex);
-			// shift all the worlds left by one, world[2] becomes equal to world[3]
-			for (std::size_t i {}; i < m_worlds.size() - 1; ++i)
+			print("soups,seed,rule,width,height,density,cap,isa,threads,seconds,soups_per_second,generations_per_second,extinct,settled,capped,population\n");
+			print("{},{},{},{},{},{},{},{},{},{:.6f},{:.1f},{:.1f},{},{},{},{}\n", results.soups, options.seed, rule_name(options.rules),
+			      width, height, options.density, options.cap, step_isa(), m_workers.size(), seconds, results.soups / seconds,
+			      results.generations / seconds, results.extinct, settled, results.capped, results.population);
+			print("\nhistogram,from,to,soups\n");
+			for (std::size_t i {}; i < results.lifespans.size(); ++i)
 			{
-				m_worlds.at(i) = m_worlds.at(i + 1);
+				if (results.lifespans[i] != 0)
+				{
+					print("lifespan,{},{},{}\n", from(i), to(i), results.lifespans[i]);
+				}
 			}
-			// lambda function to count all neighbours around given cell at X and Y coordinates
-			// world[2] is equal to world[3] at this point, so cell dies or borns later in the world[3]
-			// expression ((y + j + _coord.Y) % _coord.Y) * _coord.X + ((x + i + _coord.X) % _coord.X))
-			// makes the world toroidal so all the cells have 8 neighbours
-			auto count_neigbours {[this](uint32_t x, uint32_t y) -> uint32_t
+			for (std::size_t i {}; i < results.populations.size(); ++i)
+			{
+				if (results.populations[i] != 0)
 				{
-					uint32_t count {};
-					for (int32_t i {-1}; i < 2; ++i)
+					print("population,{},{},{}\n", from(i), to(i), results.populations[i]);
+				}
+			}
+			for (const auto & [period, soups] : results.periods)
+			{
+				print("period,{},{},{}\n", period, period, soups);
+			}
+		}
+		else
+		{
+			print("{{\"soups\": {}, \"seed\": {}, \"rule\": \"{}\", \"width\": {}, \"height\": {}, \"density\": {}, \"cap\": {}, "
+			      "\"isa\": \"{}\", \"threads\": {}, \"seconds\": {:.6f}, \"soups_per_second\": {:.1f}, \"generations_per_second\": {:.1f}, "
+			      "\"extinct\": {}, \"settled\": {}, \"capped\": {}, \"population\": {}",
+			      results.soups, options.seed, rule_name(options.rules), width, height, options.density, options.cap, step_isa(),
+			      m_workers.size(), seconds, results.soups / seconds, results.generations / seconds, results.extinct, settled,
+			      results.capped, results.population);
+			auto histogram {[&from, &to](const std::string_view name, const std::array<uint64_t, 65> & buckets)
+				{
+					print(", \"{}\": [", name);
+					bool first {true};
+					for (std::size_t i {}; i < buckets.size(); ++i)
 					{
-						for (int32_t j {-1}; j < 2; ++j)
+						if (buckets[i] != 0)
 						{
-							if (m_worlds.at(2).at(((y + j + m_coord.Y) % m_coord.Y) * m_coord.X + ((x + i + m_coord.X) % m_coord.X)) == 1)
-							{
-								if (!(i == 0 && j == 0))
-								{
-									++count;
-								}
-							}
+							print("{}{{\"from\": {}, \"to\": {}, \"soups\": {}}}", first ? "" : ", ", from(i), to(i), buckets[i]);
+							first = false;
 						}
 					}
-					return count;
+					print("]");
 				}};
-			// main nested loop to check if cell in the world[3] at given coordinates X and Y alive or not
-			// if lambda returns '2' or '3' for a living cell, it remains alive
-			// if lambda returns '3' for a dead cell, it becomes alive
+			histogram("lifespans", results.lifespans);
+			histogram("populations", results.populations);
+			print(", \"periods\": {{");
+			bool first {true};
+			for (const auto & [period, soups] : results.periods)
+			{
+				print("{}\"{}\": {}", first ? "" : ", ", period, soups);
+				first = false;
+			}
+			print("}}}}\n");
+		}
+	}
+	
+	void life::update()
+	{
+		{
+			std::lock_guard<std::mutex> lk (m_mutex);
+			// every phase starts where the one before it ended, so the clock is read once between them
+			auto time {std::chrono::steady_clock::now()};
+			advance();
+			time = m_timings.add(phase::STEP, time);
+			const uint64_t generation {m_generations + (m_universe ? m_universe->step() : 1)};
+			// cells still dying under Generations rules keep the world going a few generations after the last living one
+			const bool extinct {m_alive_cells == 0 && m_dying.empty()};
+			// hashes are kept until a cycle is found; unbounded engines are only seen through a window, which can repeat
+			// or stand still while the pattern goes on outside it, so they end by extinction only
+			history::match repeat {};
+			if (!extinct && m_cycle.period == 0 && !m_universe)
+			{
+				repeat = m_history.add(m_hash, generation);
+			}
+			time = m_timings.add(phase::HISTORY, time);
+			// check for extinction
+			outcome state {outcome::RUNNING};
+			if (extinct)
+			{
+				state = outcome::EXTINCT;
+				m_hold = true;
+			}
+			// world that has entered a cycle stays in it, a cycle of a single step means nothing changes any more
+			else if (!m_universe && (m_cycle.period != 0 || find_cycle(generation, repeat)))
+			{
+				if (m_cycle.period == generation - m_generations)
+				{
+					state = outcome::STAGNATED;
+					m_hold = true;
+				}
+				else
+				{
+					state = outcome::ETERNAL;
+				}
+			}
+			// otherwise update current state
+			else
+			{
+				m_generations = generation;
+			}
+			time = m_timings.add(phase::CYCLE, time);
+			// generations faster than frames are not copied for nothing, the one the game stops at always is
+			if (m_hold || time - m_published >= m_frame_time)
+			{
+				publish(state);
+				m_timings.add(phase::PUBLISH, time);
+			}
+			if (m_checkpoint)
+			{
+				m_checkpoint->offer(world(0), m_dying, m_generations, m_rule);
+			}
+		}
+	}
+	
+	// moves the world one step forward by the rule of the game, for Conway's one a living cell with 2 or 3 neighbours
+	// remains alive and a dead cell with 3 neighbours becomes alive
+	void life::advance()
+	{
+		// rotate the ring instead of copying worlds: the buffer holding the oldest world becomes the newest one
+		// and is overwritten by the next generation, world(1) is the current generation now
+		m_newest = (m_newest + 1) % m_worlds.size();
+		// unbounded engines move forward on their own, world(0) is the window they are seen through
+		if (m_universe)
+		{
+			m_universe->advance();
+			m_universe->read(world(0), 0, 0);
+			// births and deaths are the ones seen through the window, the population is the one of the whole universe
+			changes total {};
 			for (uint32_t y {}; y < m_coord.Y; ++y)
 			{
-				for (uint32_t x {}; x < m_coord.X; ++x)
+				total += compare(world(1), world(0), y, 0, world(0).stride());
+			}
+			m_hash ^= total.hash;
+			m_births = total.births;
+			m_deaths = total.deaths;
+			m_alive_cells = m_universe->population();
+		}
+		// dying cells of Generations rules age every generation whatever their neighbours do, so no tile is ever
+		// left as it was; every worker steps its band of rows whole and ages the dying cells in it right after
+		else if (m_dying.planes() != 0)
+		{
+			m_workers.run([this](uint32_t index)
+			{
+				const uint32_t count {m_workers.size()};
+				const uint32_t first {m_coord.Y * index / count};
+				const uint32_t last {m_coord.Y * (index + 1) / count};
+				m_kernel.step(world(1), world(0), first, last);
+				changes band {m_dying.step(world(1), world(0), first, last), 0, 0};
+				for (uint32_t y {first}; y < last; ++y)
 				{
-					uint32_t neigbours {count_neigbours(x, y)};
-					if (m_worlds.at(3).at(y * m_coord.X + x) == 1)
-					{
-						m_worlds.at(3).at(y * m_coord.X + x) = neigbours == 3 || neigbours == 2;
-					}
-					else
-					{
-						m_worlds.at(3).at(y * m_coord.X + x) = neigbours == 3;
-					}
+					band += compare(world(1), world(0), y, 0, world(0).stride());
 				}
+				m_changes[index] = band;
+			});
+			changes total {m_hash, 0, 0};
+			for (const changes & band : m_changes)
+			{
+				total += band;
 			}
-			// check for extinction
-			if (std::find(m_worlds.at(2).cbegin(), m_worlds.at(2).cend(), 1) == m_worlds.at(2).cend())
+			m_hash = total.hash;
+			m_births = total.births;
+			m_deaths = total.deaths;
+			m_alive_cells += m_births - m_deaths;
+		}
+		else
+		{
+			// every worker steps its own band of tile rows, rows next to the band are read from world(1) directly,
+			// which is not written during the step, so bands need no locking between each other
+			m_workers.run([this](uint32_t index)
 			{
-				print("All cells are dead. 'X' quit, 'R' restart\n");
-				m_hold = true;
+				const uint32_t count {m_workers.size()};
+				m_changes[index] = m_tiles.step(m_kernel, world(1), world(0), m_tiles.rows() * index / count, m_tiles.rows() * (index + 1) / count);
+			});
+			m_tiles.swap();
+			changes total {m_hash, 0, 0};
+			for (const changes & band : m_changes)
+			{
+				total += band;
 			}
-			// check if world[2] is equal to world[1], if so, it is stagnated
-			else if (std::equal(m_worlds.at(2).cbegin(), m_worlds.at(2).cend(), m_worlds.at(1).cbegin(), m_worlds.at(1).cend()))
+			// population follows from the cells that changed, so it is never counted over the whole world
+			m_hash = total.hash;
+			m_births = total.births;
+			m_deaths = total.deaths;
+			m_alive_cells += m_births - m_deaths;
+		}
+	}
+	
+	// looks for an earlier generation repeated by world(0), which is the given generation and has just been added
+	// to the history with the match m; hashes point to candidates, whole worlds are compared before a cycle is reported,
+	// with their dying cells under Generations rules, which the ring of worlds does not keep
+	bool life::find_cycle(uint64_t generation, const history::match & m)
+	{
+		const uint64_t step {m_history.steps()};
+		// candidate not repeated after its period was a collision of hashes
+		if (m_candidate.step != 0 && step > m_candidate.step + m_candidate.steps)
+		{
+			m_candidate.step = 0;
+		}
+		if (m.steps == 0)
+		{
+			return false;
+		}
+		// short periods of life-like rules are compared with worlds still in the ring
+		if (m.steps < m_worlds.size() && m_dying.planes() == 0)
+		{
+			if (world(0) == world(m.steps))
 			{
-				print("The world has stagnated. 'X' quit, 'R' restart\n");
-				m_hold = true;
+				m_cycle = {generation - m.generation, m.generation};
+				return true;
 			}
-			// check if there is situation where cells die and born at the same place so endless state appears
-			else if (std::equal(m_worlds.at(3).cbegin(), m_worlds.at(3).cend(), m_worlds.at(1).cbegin(), m_worlds.at(1).cend()) ||
-					 std::equal(m_worlds.at(3).cbegin(), m_worlds.at(3).cend(), m_worlds.at(0).cbegin(), m_worlds.at(0).cend()))
+			return false;
+		}
+		// longer ones keep a copy of the world and compare it with the world a period later
+		if (m_candidate.step == 0)
+		{
+			m_candidate.world = world(0);
+			m_candidate.dying = m_dying;
+			m_candidate.step = step;
+			m_candidate.steps = m.steps;
+			m_candidate.generation = generation;
+			m_candidate.start = m.generation;
+		}
+		else if (step == m_candidate.step + m_candidate.steps && m.steps == m_candidate.steps)
+		{
+			if (world(0) == m_candidate.world && m_dying == m_candidate.dying)
 			{
-				print("The species will live forever! 'X' quit, 'R' restart\n: ");
+				m_cycle = {generation - m_candidate.generation, m_candidate.start};
+				return true;
+			}
+			m_candidate.step = 0;
+		}
+		return false;
+	}
+	
+	// hands world(0) to the render thread; called with m_mutex locked or before the threads start,
+	// so there is only one writer of the frames at a time
+	void life::publish(outcome state)
+	{
+		frame & next {m_frames.back()};
+		next.world = world(0);
+		next.dying = m_dying;
+		next.state = state;
+		next.generation = m_generations;
+		next.population = m_alive_cells;
+		next.births = m_births;
+		next.deaths = m_deaths;
+		next.generation_time = m_generation_time;
+		next.repeats = m_cycle;
+		next.seed = m_world_seed;
+		m_frames.publish();
+		m_published = std::chrono::steady_clock::now();
+	}
+	
+	void life::render()
+	{
+		// frame is composed in full before it is printed with a single write to avoid screen flickering on windows
+		auto deadline {std::chrono::steady_clock::now()};
+		// achieved rates are measured over about a second
+		auto since {deadline};
+		uint64_t generations_since {};
+		uint32_t frames {};
+		double speed {};
+		double fps {};
+		// percentiles of the phases shown by the HUD are taken over the same second from the counts since then
+		constexpr std::size_t phases {static_cast<std::size_t>(phase::COUNT)};
+		std::array<timings::counts, phases> counted {};
+		std::array<std::array<std::chrono::nanoseconds, 2>, phases> percentiles {};
+		while (!m_quit)
+		{
+			// frames are due at fixed steps from each other, late ones are not caught up with
+			deadline += m_frame_time;
+			const auto now {std::chrono::steady_clock::now()};
+			if (now > deadline + m_frame_time)
+			{
+				deadline = now;
 			}
-			// otherwise update current state
 			else
 			{
-				m_alive_cells = static_cast<uint32_t>(std::count(m_worlds.back().cbegin(), m_worlds.back().cend(), 1));
-				print(std::format("Generation: {:>3} Cells: {:>3} {:>3} ms\n: ", m_generations, m_alive_cells, m_sleeping_time.count()));
-				++m_generations;
+				std::this_thread::sleep_until(deadline);
+			}
+			const bool fresh {m_frames.fetch()};
+			std::lock_guard<std::mutex> lk(m_terminal);
+			// the latest frame is drawn again when the view moves or something else was printed
+			if (!fresh && !m_redraw)
+			{
+				continue;
+			}
+			const frame & current {m_frames.front()};
+			if (m_redraw)
+			{
+				m_screen.invalidate();
+				m_redraw = false;
+			}
+			++frames;
+			const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - since};
+			if (elapsed >= std::chrono::seconds {1})
+			{
+				// generation counter starts again on restart
+				speed = current.generation >= generations_since ? (current.generation - generations_since) / elapsed.count() : 0;
+				fps = frames / elapsed.count();
+				since = std::chrono::steady_clock::now();
+				generations_since = current.generation;
+				frames = 0;
+				for (std::size_t p {}; p < phases; ++p)
+				{
+					const timings::counts now_counted {m_timings.read(static_cast<phase>(p))};
+					timings::counts second {};
+					for (uint32_t i {}; i < timings::buckets; ++i)
+					{
+						second[i] = now_counted[i] - counted[p][i];
+					}
+					percentiles[p] = {timings::percentile(second, 0.5), timings::percentile(second, 0.99)};
+					counted[p] = now_counted;
+				}
 			}
+			auto time {std::chrono::steady_clock::now()};
+			m_screen.clear();
+			m_screen.draw(current.world, current.dying, m_view, m_cell.alive, m_cell.dead);
+			switch (current.state)
+			{
+				case outcome::EXTINCT:
+				{
+					m_screen.write("\u001b[0mAll cells are dead. 'X' quit, 'R' restart\n: ");
+					break;
+				}
+				case outcome::STAGNATED:
+				{
+					m_screen.write("\u001b[0mThe world has stagnated. 'X' quit, 'R' restart\n: ");
+					break;
+				}
+				case outcome::ETERNAL:
+				{
+					m_screen.write("\u001b[0mThe species will live forever! Period {} since generation {}. 'X' quit, 'R' restart\n: ",
+					               current.repeats.period, current.repeats.start);
+					break;
+				}
+				default:
+				{
+					if (m_hud)
+					{
+						m_screen.write("\u001b[0mGeneration: {:>3} p50/p99", current.generation);
+						for (std::size_t p {}; p < phases; ++p)
+						{
+							m_screen.write(" {} {}/{}", phase_name(static_cast<phase>(p)), short_time(percentiles[p][0]), short_time(percentiles[p][1]));
+						}
+						m_screen.write("\n: ");
+						break;
+					}
+					m_screen.write("\u001b[0mGeneration: {:>3} Cells: {:>3} (+{}/-{}) Speed: {:.1f}/", current.generation, current.population,
+					               current.births, current.deaths, speed);
+					if (current.generation_time.count() == 0)
+					{
+						m_screen.write("max");
+					}
+					else
+					{
+						m_screen.write("{:.1f}", std::chrono::seconds {1} / std::chrono::duration<double> {current.generation_time});
+					}
+					m_screen.write(" gen/s Frames: {:.0f}/{} fps", fps, std::chrono::seconds {1} / m_frame_time);
+					if (m_view.left != 0 || m_view.top != 0 || m_view.zoom != 0)
+					{
+						m_screen.write(" View: {},{} zoom {}", m_view.left, m_view.top, m_view.zoom);
+					}
+					if (current.seed)
+					{
+						m_screen.write(" Seed: {}", *current.seed);
+					}
+					m_screen.write("\n: ");
+				}
+			}
+			time = m_timings.add(phase::FRAME, time);
+			m_screen.show();
+			m_timings.add(phase::WRITE, time);
 		}
-		std::this_thread::sleep_for(m_sleeping_time);
+	}
+	
+	grid & life::world(std::size_t age)
+	{
+		return m_worlds.at((m_newest + m_worlds.size() - age) % m_worlds.size());
 	}
 	
 	bool life::set_layout()
@@ -298,7 +735,7 @@ namespace game
 						  "[4] Oscillator\n",
 						  "[5] 6 bits\n",
 						  "[X] Exit\n"));
-		if (!m_initialization.empty())
+		if (m_initial.width() != 0)
 		{
 			print("[R] Restart current game\n");
 		}
@@ -324,9 +761,9 @@ namespace game
 			{
 				m_layout = static_cast<life::layout>(std::stoul(input));
 				// clear previous pattern written and game progress
-				if (!m_initialization.empty())
+				if (m_initial.width() != 0)
 				{
-					m_initialization.clear();
+					m_initial.clear();
 					for (auto & world : m_worlds)
 					{
 						world.clear();
@@ -349,168 +786,44 @@ namespace game
 	
 	void life::write_layout()
 	{
+		m_world_seed = {};
 		switch (m_layout)
 		{	// user defined patter from file
 			case layout::CUSTOM:
 			{
 				break;
 			}
+			// preset patterns
 			case layout::GLIDER_GUN:
-			{
-				m_coord.X = 50;
-				m_coord.Y = 26;
-				m_initialization = "--------------------------------------------------"
-				                   "--------------------------------------------------"
-				                   "--------------------------------------------------"
-				                   "--------------------------------------------------"
-				                   "--------------------------------------------------"
-				                   "--------------------------------------------------"
-				                   "--------------------------------------------------"
-				                   "--------------------------------------------------"
-				                   "------------------------------X-------------------"
-				                   "----------------------------X-X-------------------"
-				                   "------------------XX------XX------------XX--------"
-				                   "-----------------X---X----XX------------XX--------"
-				                   "------XX--------X-----X---XX----------------------"
-				                   "------XX--------X---X-XX----X-X-------------------"
-				                   "----------------X-----X-------X-------------------"
-				                   "-----------------X---X----------------------------"
-				                   "------------------XX------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------";
-				break;
-			}
 			case layout::SPACESHIP:
-			{
-				m_coord.X = 50;
-				m_coord.Y = 21;
-				m_initialization = "--------------------------------------------------"
-                                   "--------------------------------------X-----------"
-                                   "---------------------X---------------X-X----------"
-                                   "-----------X-X------X-----XX--------X-------------"
-                                   "-----------X----X----X-XXXXXX----XX---------------"
-                                   "-----------X-XXXXXXXX----------X--X-XXX-----------"
-                                   "--------------X-----X-------XXXX----XXX-----------"
-                                   "---------XX-----------------XXX-X-----------------"
-                                   "------X--XX-------XX--------XX--------------------"
-                                   "------X--X----------------------------------------"
-                                   "-----X--------------------------------------------"
-                                   "------X--X----------------------------------------"
-                                   "------X--XX-------XX--------XX--------------------"
-                                   "---------XX-----------------XXX-X-----------------"
-                                   "--------------X-----X-------XXXX----XXX-----------"
-                                   "-----------X-XXXXXXXX----------X--X-XXX-----------"
-                                   "-----------X----X----X-XXXXXX----XX---------------"
-                                   "-----------X-X------X-----XX--------X-------------"
-                                   "---------------------X---------------X-X----------"
-                                   "--------------------------------------X-----------"
-                                   "--------------------------------------------------";
-				break;
-			}
 			case layout::OSCILLATOR:
-			{
-				m_coord.X = 39;
-				m_coord.Y = 39;
-				m_initialization = "---------------------------------------"
-                                   "------------XX-----------XX------------"
-                                   "------------XX-----------XX------------"
-                                   "---------------------------------------"
-                                   "---------------------------------------"
-                                   "-------X-----------------------X-------"
-                                   "------X-X-----X---------X-----X-X------"
-                                   "-----X--X-----X-XX---XX-X-----X--X-----"
-                                   "------XX----------X-X----------XX------"
-                                   "----------------X-X-X-X----------------"
-                                   "-----------------X---X-----------------"
-                                   "---------------------------------------"
-                                   "-XX---------------------------------XX-"
-                                   "-XX---------------------------------XX-"
-                                   "------XX-----------------------XX------"
-                                   "---------------------------------------"
-                                   "-------X-X-------------------X-X-------"
-                                   "-------X--X-----------------X--X-------"
-                                   "--------XX-------------------XX--------"
-                                   "---------------------------------------"
-                                   "--------XX-------------------XX--------"
-                                   "-------X--X-----------------X--X-------"
-                                   "-------X-X-------------------X-X-------"
-                                   "---------------------------------------"
-                                   "------XX-----------------------XX------"
-                                   "-XX---------------------------------XX-"
-                                   "-XX---------------------------------XX-"
-                                   "---------------------------------------"
-                                   "-----------------X---X-----------------"
-                                   "----------------X-X-X-X----------------"
-                                   "------XX----------X-X----------XX------"
-                                   "-----X--X-----X-XX---XX-X-----X--X-----"
-                                   "------X-X-----X---------X-----X-X------"
-                                   "-------X-----------------------X-------"
-                                   "---------------------------------------"
-                                   "---------------------------------------"
-                                   "------------XX-----------XX------------"
-                                   "------------XX-----------XX------------"
-                                   "---------------------------------------";
-				break;
-			}
 			case layout::SIX_BITS:
 			{
-				m_coord.X = 50;
-				m_coord.Y = 28;
-				m_initialization = "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "-------------------------X------------------------"
-                                   "-------------------------X------------------------"
-                                   "------------------------X-X-----------------------"
-                                   "-------------------------X------------------------"
-                                   "-------------------------X------------------------"
-                                   "-------------------------X------------------------"
-                                   "-------------------------X------------------------"
-                                   "------------------------X-X-----------------------"
-                                   "-------------------------X------------------------"
-                                   "-------------------------X------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "------X--X----X--X--------------------------------"
-                                   "----XXX--XXXXXX--XXX------------------------------"
-                                   "------X--X----X--X--------------------------------"
-                                   "--------------------------XX----------------------"
-                                   "-------------------------XX-----------------------"
-                                   "---------------------------X----------------------"
-                                   "------------------------------------X----X--------"
-                                   "----------------------------------XX-XXXX-XX------"
-                                   "------------------------------------X----X--------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------"
-                                   "--------------------------------------------------";
+				pattern p {preset(static_cast<uint32_t>(m_layout))};
+				m_kernel = kernel {m_rules};
+				m_rule = rule_name(m_rules);
+				m_first_generation = 1;
+				m_coord.X = p.cells.width();
+				m_coord.Y = p.cells.height();
+				m_initial = std::move(p.cells);
+				m_initial_dying = {};
 				break;
 			}
 			// random pattern
 			default:
 			{
-				m_coord.X = random_value(5, 50);
-				m_coord.Y = random_value(4, 40);
-				m_initialization.resize(m_coord.X * m_coord.Y);
-				for (uint32_t y {}; y < m_coord.Y; ++y)
-				{
-					for (uint32_t x {}; x < m_coord.X; ++x)
-					{
-						// (0, 6) < 2 gives 30% chance for cell to become alive
-						if (random_value(0, 6) < 2)
-						{
-							m_initialization.at(y * m_coord.X + x) = 'X';
-							++m_alive_cells;
-						}
-					}
-				}
+				// the seed of this world given by --seed makes it again, the next one follows from it
+				m_world_seed = m_seed;
+				m_seed = mix(m_seed);
+				generator random {*m_world_seed};
+				m_coord.X = m_size.X ? m_size.X : 5 + random.below(46);
+				m_coord.Y = m_size.Y ? m_size.Y : 4 + random.below(37);
+				m_initial.resize(m_coord.X, m_coord.Y);
+				m_initial_dying = {};
+				m_kernel = kernel {m_rules};
+				m_rule = rule_name(m_rules);
+				m_first_generation = 1;
+				fill(m_initial, random(), m_density, m_workers);
 				break;
 			}
 		}
@@ -518,17 +831,42 @@ namespace game
 	
 	void life::read_layout()
 	{
-		m_worlds.fill(std::vector<uint32_t>(m_coord.X * m_coord.Y));
-		for (uint32_t y {}; y < m_coord.Y; ++y)
+		for (auto & world : m_worlds)
+		{
+			world.resize(m_coord.X, m_coord.Y);
+		}
+		m_tiles.resize(m_coord.X, m_coord.Y, static_cast<uint32_t>(m_worlds.size()));
+		if (m_universe)
+		{
+			m_universe->clear(m_kernel.rule());
+		}
+		m_dying.resize(m_coord.X, m_coord.Y, m_kernel.rule().states);
+		// pattern smaller than the world is put in the middle of it
+		place(m_initial, world(0), (m_coord.X - m_initial.width()) / 2, (m_coord.Y - m_initial.height()) / 2);
+		place(m_initial_dying, m_dying, (m_coord.X - m_initial.width()) / 2, (m_coord.Y - m_initial.height()) / 2);
+		if (m_universe)
 		{
-			for (uint32_t x {}; x < m_coord.X; ++x)
+			for (uint32_t y {}; y < m_coord.Y; ++y)
 			{
-				if (m_initialization.at(y * m_coord.X + x) == 'X')
+				for (uint32_t x {}; x < m_coord.X; ++x)
 				{
-					m_worlds.back().at(y * m_coord.X + x) = 1;
+					if (world(0).get(x, y))
+					{
+						m_universe->set(x, y);
+					}
 				}
 			}
 		}
+		m_alive_cells = world(0).population();
+		m_births = 0;
+		m_deaths = 0;
+		m_generations = m_first_generation;
+		// cycles are looked for from the first generation on
+		m_hash = world(0).hash() ^ m_dying.hash();
+		m_history.clear();
+		m_history.add(m_hash, m_generations);
+		m_candidate.step = 0;
+		m_cycle = {};
 	}
 	
 	void life::ingame_user_input()
@@ -537,8 +875,26 @@ namespace game
 		while (!m_quit)
 		{
 			std::getline(std::cin, input);
-			if (std::cin.eof()) { std::cin.clear(); }
-			if (!input.empty())
+			if (std::cin.eof())
+			{
+				std::cin.clear();
+			}
+			else
+			{
+				// typed line is echoed and may scroll the terminal, so the board is drawn anew
+				std::lock_guard<std::mutex> lk(m_terminal);
+				m_redraw = true;
+			}
+			// moving and zooming the view, keys can be repeated on one line
+			if (!input.empty() && input.find_first_not_of("wasdWASD+-") == std::string::npos)
+			{
+				std::lock_guard<std::mutex> lk(m_terminal);
+				for (char key : input)
+				{
+					move_view(key);
+				}
+			}
+			else if (!input.empty())
 			{
 				std::lock_guard<std::mutex> lk(m_mutex);
 				switch (input.front())
@@ -546,9 +902,10 @@ namespace game
 					case 'r':
 					case 'R':
 					{
+						std::lock_guard<std::mutex> terminal_lk(m_terminal);
 						if (set_layout())
 						{
-							m_generations = 1;
+							publish(outcome::RUNNING);
 							if (m_hold)
 							{
 								m_hold = false;
@@ -561,6 +918,16 @@ namespace game
 						}
 						break;
 					}
+					// save current generation to a file as a pattern or as a snapshot to be resumed
+					case 'e':
+					case 'E':
+					case 'b':
+					case 'B':
+					{
+						std::lock_guard<std::mutex> terminal_lk(m_terminal);
+						write_file(input.front() == 'b' || input.front() == 'B');
+						break;
+					}
 					// pause game for a while
 					case 'k':
 					case 'K':
@@ -576,20 +943,31 @@ namespace game
 						}
 						break;
 					}
+					// show times of the phases instead of the status line or back
+					case 'h':
+					case 'H':
+					{
+						m_hud = !m_hud;
+						break;
+					}
 					// change output colour of alive cells
 					case 'c':
 					case 'C':
 					{
-						++m_cell.alive;
-						if (m_cell.alive == m_cell.dead) { ++m_cell.alive; }
+						colour c {m_cell.alive};
+						++c;
+						if (c == m_cell.dead) { ++c; }
+						m_cell.alive = c;
 						break;
 					}
 					// change colour of dead cells
 					case 'v':
 					case 'V':
 					{
-						++m_cell.dead;
-						if (m_cell.dead == m_cell.alive) { ++m_cell.dead; }
+						colour c {m_cell.dead};
+						++c;
+						if (c == m_cell.alive) { ++c; }
+						m_cell.dead = c;
 						break;
 					}
 					case 'x':
@@ -613,7 +991,8 @@ namespace game
 						{
 							try
 							{
-								m_sleeping_time = static_cast<std::chrono::milliseconds>(std::stoul(input));
+								m_generation_time = std::chrono::milliseconds {std::stoul(input)};
+								m_interaction.notify_one();
 							}
 							// catch blocks are empty because there is no reason to notify user if last input was wrong
 							// because screen will clear immideately and user won't notice anything
@@ -632,55 +1011,180 @@ namespace game
 		}
 	}
 	
+	// pans by 16 characters sideways or 8 rows up and down whatever the zoom is, called with m_terminal locked
+	void life::move_view(char key)
+	{
+		const int64_t step {int64_t {8} << m_view.zoom};
+		auto shift {[](uint32_t position, int64_t offset, uint32_t size) -> uint32_t
+			{
+				return static_cast<uint32_t>(std::clamp<int64_t>(position + offset, 0, std::max<int64_t>(size, 1) - 1));
+			}};
+		switch (key)
+		{
+			case 'w':
+			case 'W':
+			{
+				m_view.top = shift(m_view.top, -step, m_coord.Y);
+				break;
+			}
+			case 's':
+			case 'S':
+			{
+				m_view.top = shift(m_view.top, step, m_coord.Y);
+				break;
+			}
+			case 'a':
+			case 'A':
+			{
+				m_view.left = shift(m_view.left, -step, m_coord.X);
+				break;
+			}
+			case 'd':
+			case 'D':
+			{
+				m_view.left = shift(m_view.left, step, m_coord.X);
+				break;
+			}
+			// a dot of the furthest zoom covers 256x256 cells
+			case '-':
+			{
+				m_view.zoom = std::min(m_view.zoom + 1, 10u);
+				break;
+			}
+			case '+':
+			{
+				m_view.zoom = m_view.zoom == 0 ? 0 : m_view.zoom - 1;
+				break;
+			}
+		}
+	}
+	
 	bool life::read_file(const std::string_view filename)
 	{
-		std::ifstream fin {filename.data(), std::ios_base::in};
-		if (!fin.is_open())
+		const mapped_file file {std::string {filename}};
+		if (!file.is_open())
 		{
 			print("\u001b[2J\u001b[H");
 			print("Could not open \"{}\"\n\n", filename);
 			return false;
 		}
+		pattern p {};
+		uint64_t generation {1};
+		uint32_t x {};
+		uint32_t y {};
+		uint64_t line {};
+		parsed state {};
+		if (is_snapshot(file.text()))
+		{
+			snapshot s {};
+			state = read_snapshot(file.text(), s);
+			p.cells = std::move(s.cells);
+			p.rule = std::move(s.rule);
+			p.dying = std::move(s.dying);
+			generation = s.generation;
+		}
 		else
 		{
-			fin >> m_coord.Y >> m_coord.X;
-			m_initialization.resize(m_coord.X * m_coord.Y);
-			uint32_t x {};
-			uint32_t y {};
-			try
+			state = read_pattern(file.text(), p, x, y, line, m_workers);
+		}
+		switch (state)
+		{
+			// snapshots have no lines
+			case parsed::UNREADABLE:
 			{
-				while (fin.good())
-				{
-					fin >> y >> x;
-					m_initialization.at(y * m_coord.X + x) = 'X';
-					++m_alive_cells;
-				}
-				if (!fin.eof())
+				print("\u001b[2J\u001b[H");
+				if (line == 0)
 				{
-					print("\u001b[2J\u001b[H");
 					print("Could not read \"{}\"\n\n", filename);
-					return false;
 				}
 				else
 				{
-					m_layout = layout::CUSTOM;
-					return true;
+					print("Could not read line {} of \"{}\"\n\n", line, filename);
 				}
+				return false;
 			}
-			catch (const std::out_of_range & ex)
+			case parsed::OUT_OF_RANGE:
+			{
+				print("\u001b[2J\u001b[H");
+				print("Out of range coordinates at \"{}\" and \"{}\" on line {}\n\n", x, y, line);
+				return false;
+			}
+			case parsed::UNSUPPORTED_RULE:
 			{
 				print("\u001b[2J\u001b[H");
-				print("Out of range coordinates at \"{}\" and \"{}\"\n\n", x, y);
+				print("Rule \"{}\" is not supported\n\n", p.rule);
 				return false;
 			}
+			default:
+			{
+				// files naming no rule are played by the one given by the user
+				rule r {m_rules};
+				if (!p.rule.empty())
+				{
+					parse_rule(p.rule, r);
+				}
+				// unbounded engines keep living cells only
+				if (m_universe && r.states > 2)
+				{
+					print("\u001b[2J\u001b[H");
+					print("Rule \"{}\" is played on the torus only\n\n", rule_name(r));
+					return false;
+				}
+				m_kernel = kernel {r};
+				m_rule = rule_name(r);
+				// size given on the command line makes room around the pattern
+				m_coord.X = std::max(p.cells.width(), m_size.X);
+				m_coord.Y = std::max(p.cells.height(), m_size.Y);
+				m_initial = std::move(p.cells);
+				m_initial_dying = std::move(p.dying);
+				m_first_generation = generation;
+				m_layout = layout::CUSTOM;
+				return true;
+			}
 		}
 	}
 	
-	uint32_t life::random_value(uint32_t min, uint32_t max)
+	// saves the current generation as a run length encoded pattern or with its number as a snapshot,
+	// called with both mutexes locked
+	void life::write_file(bool whole_state)
 	{
-		std::random_device rd {};
-		std::mt19937 engine {rd()};
-		std::uniform_int_distribution<uint32_t>distribution {min, max};
-		return distribution(engine);
+		print("\u001b[2J\u001b[H");
+		std::string filename;
+		// snapshot of an unbounded engine would hold its window only
+		if (whole_state && m_universe)
+		{
+			print("Snapshots are saved on the torus only, press Enter to continue\n");
+			std::getline(std::cin, filename);
+			if (!std::cin) { std::cin.clear(); }
+			return;
+		}
+		print("Enter filename to save generation {}\n", m_generations);
+		while (filename.empty())
+		{
+			print(": ");
+			std::getline(std::cin, filename);
+			if (!std::cin) { std::cin.clear(); }
+		}
+		bool written {};
+		if (whole_state)
+		{
+			written = save_snapshot(filename, {world(0), m_generations, m_rule, m_dying});
+		}
+		else
+		{
+			std::ofstream fout {filename, std::ios_base::out};
+			if (fout.is_open())
+			{
+				write_rle(fout, world(0), m_dying, m_rule);
+			}
+			written = static_cast<bool>(fout);
+		}
+		if (!written)
+		{
+			// message would be gone with the next frame, so it stays until the user sees it
+			print("Could not write \"{}\", press Enter to continue\n", filename);
+			std::getline(std::cin, filename);
+			if (!std::cin) { std::cin.clear(); }
+		}
 	}
 }
@@ -6,10 +6,25 @@
 //
 
 #pragma once
+#include "grid.h"
+#include "pool.h"
+#include "decay.h"
+#include "tiles.h"
+#include "kernel.h"
+#include "history.h"
+#include "screen.h"
+#include "settings.h"
+#include "timings.h"
+#include "snapshot.h"
+#include "universe.h"
+#include "triple_buffer.h"
 #include <mutex>
+#include <memory>
 #include <array>
+#include <atomic>
 #include <vector>
 #include <format>
+#include <optional>
 #include <chrono>
 #include <thread>
 #include <string>
@@ -21,32 +36,38 @@ namespace game
 	class life
 	{
 	public:
-		life();
+		explicit life(const settings & options);
 		~life();
 		void begin();
 		void begin(const std::string_view filename);
+		// starts with the pattern of the presets menu with the given number instead of the menu
+		void begin(uint32_t preset);
+		// runs the given number of generations without output and pauses, then reports the speed of the engine
+		bool benchmark(const settings & options);
+		// runs a soup search instead of the game and reports what became of the soups
+		void search(const settings & options);
 	private:
 		void run();
 		void end();
 		void update();
+		void advance();
+		bool find_cycle(uint64_t generation, const history::match & m);
+		void render();
 		bool set_layout();
 		void write_layout();
 		void read_layout();
+		grid & world(std::size_t age);
 		void ingame_user_input();
+		void move_view(char key);
 		bool read_file(const std::string_view filename);
-		uint32_t random_value(uint32_t min, uint32_t max);
+		void write_file(bool whole_state);
 	private:
-		enum class colour : uint32_t
+		enum class outcome : uint32_t
 		{
-			DEFAULT	= 0,
-			BLACK	= 30,
-			RED		= 31,
-			GREEN	= 32,
-			YELLOW	= 33,
-			BLUE	= 34,
-			MAGENTA = 35,
-			CYAN	= 36,
-			WHITE	= 37
+			RUNNING,
+			EXTINCT,
+			STAGNATED,
+			ETERNAL														// generations repeat in a cycle forever
 		};
 		enum class layout : uint32_t
 		{
@@ -60,31 +81,92 @@ namespace game
 		struct cell
 		{
 			cell();
-			colour dead;
-			colour alive;
-			const std::string symbol;
+			std::atomic<colour> dead;									// changed by user input while the render thread reads them
+			std::atomic<colour> alive;
 		};
 		struct coordinate
 		{
 			uint32_t X;
 			uint32_t Y;
-		};		
-		friend std::formatter<life::colour>;
-		friend colour operator ++ (colour & c);
-		friend bool operator == (colour lhs, colour rhs);
+		};
+		// cycle of generations the world has entered, found by hashes and confirmed by comparing whole worlds
+		struct cycle
+		{
+			uint64_t period;											// generations, zero while no cycle is found
+			uint64_t start;												// generation the cycle was first seen at
+		};
+		// world repeating the hash of one too old for the ring, compared once more with the one a period later
+		struct candidate
+		{
+			grid world;
+			decay dying;
+			uint64_t step;												// step of the history it was taken at, zero if none
+			uint64_t steps;												// period in steps of the history
+			uint64_t generation;
+			uint64_t start;
+		};
+		// generation handed from the update thread to the render thread
+		struct frame
+		{
+			grid world;
+			decay dying;
+			outcome state;
+			uint64_t generation;
+			uint64_t population;
+			uint64_t births;
+			uint64_t deaths;
+			std::chrono::nanoseconds generation_time;
+			cycle repeats;
+			std::optional<uint64_t> seed;								// of a random world, shown so it can be played again
+		};
+		void publish(outcome state);
 	private:
 		bool m_hold;													// flag to hold back execution of child thread
-		bool m_quit;													// flag to stop execution the programm
+		std::atomic<bool> m_quit;										// flag to stop execution the programm
 		cell m_cell;
 		layout m_layout;												// initial cells pattern
 		coordinate m_coord;
+		const coordinate m_size;										// size of random worlds given by the user, zero if not
+		const rule m_rules;												// rule of random and preset worlds given by the user
+		const uint32_t m_density;										// percent of living cells in random worlds
+		uint64_t m_seed;												// seed of the next random world, each one gives the seed of the one after it
+		std::optional<uint64_t> m_world_seed;							// seed of the current world if it is a random one
 		std::mutex m_mutex;
-		uint32_t m_alive_cells;
-		uint32_t m_generations;
+		uint64_t m_alive_cells;											// kept up to date from births and deaths, not counted
+		uint64_t m_births;												// cells born in the last step
+		uint64_t m_deaths;												// cells died in the last step
+		uint64_t m_generations;
+		uint64_t m_first_generation;									// generation of m_initial, a later one for resumed games
 		std::thread m_update_thread;
-		std::string m_initialization;
+		std::thread m_render_thread;
+		std::mutex m_terminal;											// output of the render thread and menus must not mix
+		bool m_redraw;													// terminal was written by others, guarded by m_terminal
+		view m_view;													// part of the world on the screen, guarded by m_terminal
+		grid m_initial;													// first generation of the current game
+		decay m_initial_dying;											// dying cells of it for Generations rules
 		std::condition_variable m_interaction;							// interaction between threads
-		std::chrono::milliseconds m_sleeping_time;
-		std::array<std::vector<uint32_t>, 4> m_worlds;
+		std::chrono::nanoseconds m_generation_time;						// time between generations, zero runs them at full speed
+		const std::chrono::nanoseconds m_frame_time;					// time between frames drawn on the terminal
+		std::chrono::steady_clock::time_point m_published;				// when the last frame was handed to the render thread
+		std::size_t m_newest;											// index of the latest generation in the ring of worlds
+		std::array<grid, 4> m_worlds;									// ring of the last generations, world(0) is the newest one
+		decay m_dying;													// dying cells of world(0), aged in place every step
+		kernel m_kernel;												// next generation by the rule of the current game
+		std::string m_rule;												// same rule in B/S notation, saved with the game
+		tiles m_tiles;													// skips parts of the world that have not changed
+		pool m_workers;													// threads stepping horizontal bands of the world
+		std::vector<changes> m_changes;									// what the last step changed in the band of every worker
+		uint64_t m_hash;												// hash of world(0) and its dying cells, updated from the words that changed
+		history m_history;												// hashes of the generations within the longest period
+		candidate m_candidate;
+		cycle m_cycle;
+		std::unique_ptr<universe> m_universe;							// unbounded engine used instead of the torus if chosen
+		triple_buffer<frame> m_frames;									// latest generations for the render thread
+		screen m_screen;												// frame being composed by the render thread
+		std::unique_ptr<checkpoint> m_checkpoint;						// saves the game now and then if asked to
+		timings m_timings;												// how long every phase takes, always counted
+		std::atomic<bool> m_hud;										// times of the phases shown instead of the status line
+		const std::string m_timings_file;								// times written here on exit, none if empty
+		const report m_format;											// how they are written
 	};
 }
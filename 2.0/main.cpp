@@ -6,6 +6,8 @@
 //
 
 #include "life.h"
+#include <cstdio>
+#include <filesystem>
 #ifdef _WIN32
 #include <Windows.h>
 #endif
@@ -15,10 +17,37 @@ int main(int argc, const char * argv[])
 #ifdef _WIN32
 	SetConsoleOutputCP(CP_UTF8);
 #endif
-	game::life life;
-	if (argc == 2)
+	game::settings options;
+	if (!game::parse_settings(argc, argv, options))
 	{
-		life.begin(argv[1]);
+		fputs("Usage: CMakeTarget [--threads N] [--engine torus|hashlife|sparse] [--step K] [--cache MB]\n"
+		      "                   [--preset 1-5] [--size WxH] [--rate G] [--fps F] [--bench N] [--format json|csv]\n"
+		      "                   [--checkpoint FILE] [--interval S] [--period P] [--rule B/S[/C]] [--timings FILE]\n"
+		      "                   [--search N] [--seed S] [--density P] [--cap G] [filename]\n", stderr);
+		return 1;
+	}
+	// game checkpointed before is resumed by running the same command again
+	if (options.filename.empty() && !options.checkpoint.empty() && std::filesystem::exists(options.checkpoint))
+	{
+		options.filename = options.checkpoint;
+	}
+	game::life life {options};
+	if (options.soups != 0)
+	{
+		life.search(options);
+		return 0;
+	}
+	if (options.generations != 0)
+	{
+		return life.benchmark(options) ? 0 : 1;
+	}
+	if (!options.filename.empty())
+	{
+		life.begin(options.filename);
+	}
+	else if (options.preset != 0)
+	{
+		life.begin(options.preset);
 	}
 	else
 	{
@@ -0,0 +1,100 @@
+//
+//  mapped_file.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "mapped_file.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace game
+{
+	mapped_file::mapped_file(const std::string & filename) : m_open(false),
+	                                                         m_data(nullptr),
+	                                                         m_size()
+	{
+		// handles are closed as soon as the view exists, the view keeps the file open by itself
+#ifdef _WIN32
+		const HANDLE file {CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+		LARGE_INTEGER size {};
+		if (GetFileSizeEx(file, &size))
+		{
+			m_size = static_cast<std::size_t>(size.QuadPart);
+			m_open = m_size == 0;
+			if (m_size != 0)
+			{
+				const HANDLE mapping {CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+				if (mapping != nullptr)
+				{
+					m_data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+					m_open = m_data != nullptr;
+					CloseHandle(mapping);
+				}
+			}
+		}
+		CloseHandle(file);
+#else
+		const int file {::open(filename.c_str(), O_RDONLY)};
+		if (file == -1)
+		{
+			return;
+		}
+		struct stat status {};
+		if (fstat(file, &status) == 0 && S_ISREG(status.st_mode))
+		{
+			m_size = static_cast<std::size_t>(status.st_size);
+			m_open = m_size == 0;
+			if (m_size != 0)
+			{
+				void * data {mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0)};
+				if (data != MAP_FAILED)
+				{
+					// file is read once from the beginning to the end
+					madvise(data, m_size, MADV_SEQUENTIAL);
+					m_data = static_cast<const char *>(data);
+					m_open = true;
+				}
+			}
+		}
+		::close(file);
+#endif
+		if (!m_open)
+		{
+			m_size = 0;
+		}
+	}
+	
+	mapped_file::~mapped_file()
+	{
+		if (m_data != nullptr)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(m_data);
+#else
+			munmap(const_cast<char *>(m_data), m_size);
+#endif
+		}
+	}
+	
+	bool mapped_file::is_open() const
+	{
+		return m_open;
+	}
+	
+	std::string_view mapped_file::text() const
+	{
+		return {m_data, m_size};
+	}
+}
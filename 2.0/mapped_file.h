@@ -0,0 +1,30 @@
+//
+//  mapped_file.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include <string>
+#include <cstddef>
+#include <string_view>
+
+namespace game
+{
+	// whole file mapped into memory read-only, so it is parsed where the system keeps it instead of being copied by a stream
+	class mapped_file
+	{
+	public:
+		explicit mapped_file(const std::string & filename);
+		~mapped_file();
+		mapped_file(const mapped_file &) = delete;
+		mapped_file & operator = (const mapped_file &) = delete;
+		bool is_open() const;
+		std::string_view text() const;
+	private:
+		bool m_open;
+		const char * m_data;											// null for empty files, they cannot be mapped
+		std::size_t m_size;
+	};
+}
@@ -0,0 +1,608 @@
+//
+//  patterns.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "patterns.h"
+#include "rule.h"
+#include "settings.h"
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <streambuf>
+
+namespace
+{
+	// rows of 'X' for living cells and anything else for dead ones
+	game::pattern from_text(uint32_t width, uint32_t height, const std::string_view text)
+	{
+		game::pattern p {game::grid {width, height}, {}, {}};
+		for (uint32_t y {}; y < height; ++y)
+		{
+			for (uint32_t x {}; x < width; ++x)
+			{
+				if (text[static_cast<std::size_t>(y) * width + x] == 'X')
+				{
+					p.cells.set(x, y, true);
+				}
+			}
+		}
+		return p;
+	}
+	
+	// makes count cells alive from x on, a word at a time
+	void fill(game::grid & cells, uint32_t x, uint32_t y, uint32_t count)
+	{
+		uint64_t * row {cells.row(y)};
+		while (count != 0)
+		{
+			const uint32_t bit {x & 63};
+			const uint32_t taken {std::min(count, 64 - bit)};
+			const uint64_t mask {taken == 64 ? ~uint64_t {} : (uint64_t {1} << taken) - 1};
+			row[x >> 6] |= mask << bit;
+			x += taken;
+			count -= taken;
+		}
+	}
+	
+	std::string_view trim(std::string_view text)
+	{
+		while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+		{
+			text.remove_prefix(1);
+		}
+		while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+		{
+			text.remove_suffix(1);
+		}
+		return text;
+	}
+	
+	bool to_number(const std::string_view text, uint32_t & value)
+	{
+		auto [end, error] {std::from_chars(text.data(), text.data() + text.size(), value)};
+		return error == std::errc {} && end == text.data() + text.size();
+	}
+	
+	bool horizontal_space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+	
+	// two numbers separated by spaces and followed by the end of the line, which is passed over
+	bool read_pair(const char * & next, const char * end, uint32_t & first, uint32_t & second)
+	{
+		auto [after_first, first_error] {std::from_chars(next, end, first)};
+		if (first_error != std::errc {} || after_first == end || !horizontal_space(*after_first))
+		{
+			return false;
+		}
+		next = after_first;
+		while (next != end && horizontal_space(*next))
+		{
+			++next;
+		}
+		auto [after_second, second_error] {std::from_chars(next, end, second)};
+		if (second_error != std::errc {})
+		{
+			return false;
+		}
+		next = after_second;
+		while (next != end && horizontal_space(*next))
+		{
+			++next;
+		}
+		if (next == end)
+		{
+			return true;
+		}
+		return *next++ == '\n';
+	}
+	
+	// lines of Y and X from begin to end, lines counts the ones passed before an error or all of them;
+	// shared grids are written atomically, since a word can hold cells of lines parsed by other threads
+	template <bool shared>
+	game::parsed read_cells(const char * next, const char * end, game::grid & cells, uint32_t & x, uint32_t & y, uint64_t & lines)
+	{
+		lines = 0;
+		while (next != end)
+		{
+			if (*next == '\n' || horizontal_space(*next))
+			{
+				lines += *next++ == '\n';
+				continue;
+			}
+			if (!read_pair(next, end, y, x))
+			{
+				return game::parsed::UNREADABLE;
+			}
+			if (x >= cells.width() || y >= cells.height())
+			{
+				return game::parsed::OUT_OF_RANGE;
+			}
+			uint64_t & word {cells.row(y)[x >> 6]};
+			const uint64_t mask {uint64_t {1} << (x & 63)};
+			if constexpr (shared)
+			{
+				std::atomic_ref<uint64_t> {word}.fetch_or(mask, std::memory_order_relaxed);
+			}
+			else
+			{
+				word |= mask;
+			}
+			// read_pair() took the end of the line too
+			++lines;
+		}
+		return game::parsed::OK;
+	}
+	
+	// lets the stream based reader take text that is already in memory without a copy
+	class text_buffer : public std::streambuf
+	{
+	public:
+		explicit text_buffer(const std::string_view text)
+		{
+			char * begin {const_cast<char *>(text.data())};
+			setg(begin, begin, begin + text.size());
+		}
+	};
+}
+
+namespace game
+{
+	pattern preset(uint32_t number)
+	{
+		switch (number)
+		{
+			// glider gun
+			case 2:
+			{
+				return from_text(50, 26, "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "------------------------------X-------------------"
+				                         "----------------------------X-X-------------------"
+				                         "------------------XX------XX------------XX--------"
+				                         "-----------------X---X----XX------------XX--------"
+				                         "------XX--------X-----X---XX----------------------"
+				                         "------XX--------X---X-XX----X-X-------------------"
+				                         "----------------X-----X-------X-------------------"
+				                         "-----------------X---X----------------------------"
+				                         "------------------XX------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------");
+			}
+			// spaceship
+			case 3:
+			{
+				return from_text(50, 21, "--------------------------------------------------"
+				                         "--------------------------------------X-----------"
+				                         "---------------------X---------------X-X----------"
+				                         "-----------X-X------X-----XX--------X-------------"
+				                         "-----------X----X----X-XXXXXX----XX---------------"
+				                         "-----------X-XXXXXXXX----------X--X-XXX-----------"
+				                         "--------------X-----X-------XXXX----XXX-----------"
+				                         "---------XX-----------------XXX-X-----------------"
+				                         "------X--XX-------XX--------XX--------------------"
+				                         "------X--X----------------------------------------"
+				                         "-----X--------------------------------------------"
+				                         "------X--X----------------------------------------"
+				                         "------X--XX-------XX--------XX--------------------"
+				                         "---------XX-----------------XXX-X-----------------"
+				                         "--------------X-----X-------XXXX----XXX-----------"
+				                         "-----------X-XXXXXXXX----------X--X-XXX-----------"
+				                         "-----------X----X----X-XXXXXX----XX---------------"
+				                         "-----------X-X------X-----XX--------X-------------"
+				                         "---------------------X---------------X-X----------"
+				                         "--------------------------------------X-----------"
+				                         "--------------------------------------------------");
+			}
+			// oscillator
+			case 4:
+			{
+				return from_text(39, 39, "---------------------------------------"
+				                         "------------XX-----------XX------------"
+				                         "------------XX-----------XX------------"
+				                         "---------------------------------------"
+				                         "---------------------------------------"
+				                         "-------X-----------------------X-------"
+				                         "------X-X-----X---------X-----X-X------"
+				                         "-----X--X-----X-XX---XX-X-----X--X-----"
+				                         "------XX----------X-X----------XX------"
+				                         "----------------X-X-X-X----------------"
+				                         "-----------------X---X-----------------"
+				                         "---------------------------------------"
+				                         "-XX---------------------------------XX-"
+				                         "-XX---------------------------------XX-"
+				                         "------XX-----------------------XX------"
+				                         "---------------------------------------"
+				                         "-------X-X-------------------X-X-------"
+				                         "-------X--X-----------------X--X-------"
+				                         "--------XX-------------------XX--------"
+				                         "---------------------------------------"
+				                         "--------XX-------------------XX--------"
+				                         "-------X--X-----------------X--X-------"
+				                         "-------X-X-------------------X-X-------"
+				                         "---------------------------------------"
+				                         "------XX-----------------------XX------"
+				                         "-XX---------------------------------XX-"
+				                         "-XX---------------------------------XX-"
+				                         "---------------------------------------"
+				                         "-----------------X---X-----------------"
+				                         "----------------X-X-X-X----------------"
+				                         "------XX----------X-X----------XX------"
+				                         "-----X--X-----X-XX---XX-X-----X--X-----"
+				                         "------X-X-----X---------X-----X-X------"
+				                         "-------X-----------------------X-------"
+				                         "---------------------------------------"
+				                         "---------------------------------------"
+				                         "------------XX-----------XX------------"
+				                         "------------XX-----------XX------------"
+				                         "---------------------------------------");
+			}
+			// 6 bits
+			case 5:
+			{
+				return from_text(50, 28, "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "-------------------------X------------------------"
+				                         "-------------------------X------------------------"
+				                         "------------------------X-X-----------------------"
+				                         "-------------------------X------------------------"
+				                         "-------------------------X------------------------"
+				                         "-------------------------X------------------------"
+				                         "-------------------------X------------------------"
+				                         "------------------------X-X-----------------------"
+				                         "-------------------------X------------------------"
+				                         "-------------------------X------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "------X--X----X--X--------------------------------"
+				                         "----XXX--XXXXXX--XXX------------------------------"
+				                         "------X--X----X--X--------------------------------"
+				                         "--------------------------XX----------------------"
+				                         "-------------------------XX-----------------------"
+				                         "---------------------------X----------------------"
+				                         "------------------------------------X----X--------"
+				                         "----------------------------------XX-XXXX-XX------"
+				                         "------------------------------------X----X--------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------"
+				                         "--------------------------------------------------");
+			}
+			default:
+			{
+				return {};
+			}
+		}
+	}
+	
+	parsed read_pattern(const std::string_view text, pattern & p, uint32_t & x, uint32_t & y, uint64_t & line, pool & workers)
+	{
+		const std::size_t first {text.find_first_not_of(" \t\r\n")};
+		if (first == std::string_view::npos || (text[first] != '#' && text[first] != 'x'))
+		{
+			return read_coordinates(text, p, x, y, line, workers);
+		}
+		text_buffer buffer {text};
+		std::istream in {&buffer};
+		return read_rle(in, p, x, y, line);
+	}
+	
+	parsed read_coordinates(const std::string_view text, pattern & p, uint32_t & x, uint32_t & y, uint64_t & line, pool & workers)
+	{
+		const char * const end {text.data() + text.size()};
+		const char * next {text.data()};
+		// header may follow empty lines
+		line = 1;
+		while (next != end && std::isspace(static_cast<unsigned char>(*next)))
+		{
+			line += *next++ == '\n';
+		}
+		uint32_t width {};
+		uint32_t height {};
+		if (!read_pair(next, end, height, width) || width == 0 || height == 0 || width > max_side || height > max_side)
+		{
+			return parsed::UNREADABLE;
+		}
+		++line;
+		p.cells.resize(width, height);
+		p.rule.clear();
+		// parts start at the beginning of a line, small files are not worth waking the workers for
+		const std::size_t size {static_cast<std::size_t>(end - next)};
+		const uint32_t count {size < (std::size_t {1} << 20) ? 1 : workers.size()};
+		std::vector<const char *> bounds(count + 1, end);
+		bounds[0] = next;
+		for (uint32_t i {1}; i < count; ++i)
+		{
+			const char * start {std::max(next + size * i / count, bounds[i - 1])};
+			start = static_cast<const char *>(std::memchr(start, '\n', static_cast<std::size_t>(end - start)));
+			bounds[i] = start == nullptr ? end : start + 1;
+		}
+		struct result
+		{
+			parsed state;
+			uint32_t x;
+			uint32_t y;
+			uint64_t lines;
+		};
+		std::vector<result> results(count, {parsed::OK, 0, 0, 0});
+		if (count == 1)
+		{
+			result & r {results[0]};
+			r.state = read_cells<false>(bounds[0], bounds[1], p.cells, r.x, r.y, r.lines);
+		}
+		else
+		{
+			workers.run([&](uint32_t index)
+			{
+				result & r {results[index]};
+				r.state = read_cells<true>(bounds[index], bounds[index + 1], p.cells, r.x, r.y, r.lines);
+			});
+		}
+		// first broken part is reported, with the lines of the parts before it
+		for (const result & r : results)
+		{
+			x = r.x;
+			y = r.y;
+			line += r.lines;
+			if (r.state != parsed::OK)
+			{
+				return r.state;
+			}
+		}
+		return parsed::OK;
+	}
+	
+	parsed read_rle(std::istream & in, pattern & p, uint32_t & x, uint32_t & y, uint64_t & line)
+	{
+		std::string header;
+		line = 0;
+		while (std::getline(in, header) && (++line, trim(header).empty() || header.front() == '#'))
+		{
+			
+		}
+		if (!in)
+		{
+			return parsed::UNREADABLE;
+		}
+		// header is a list of name = value pairs, the rule may be left out
+		uint32_t width {};
+		uint32_t height {};
+		p.rule.clear();
+		for (std::string_view rest {header}; !rest.empty(); )
+		{
+			const std::size_t comma {rest.find(',')};
+			const std::string_view item {rest.substr(0, comma)};
+			rest = comma == std::string_view::npos ? std::string_view {} : rest.substr(comma + 1);
+			const std::size_t equals {item.find('=')};
+			if (equals == std::string_view::npos)
+			{
+				return parsed::UNREADABLE;
+			}
+			const std::string_view name {trim(item.substr(0, equals))};
+			const std::string_view value {trim(item.substr(equals + 1))};
+			if ((name == "x" && !to_number(value, width)) || (name == "y" && !to_number(value, height)))
+			{
+				return parsed::UNREADABLE;
+			}
+			if (name == "rule")
+			{
+				p.rule = value;
+			}
+		}
+		if (width == 0 || height == 0 || width > max_side || height > max_side)
+		{
+			return parsed::UNREADABLE;
+		}
+		rule r {conway};
+		if (!p.rule.empty() && !parse_rule(p.rule, r))
+		{
+			return parsed::UNSUPPORTED_RULE;
+		}
+		p.cells.resize(width, height);
+		p.dying.resize(width, height, r.states);
+		// body is read in blocks straight into the grid, with no copy of the board in between
+		std::array<char, 65536> block;
+		uint32_t count {};
+		x = 0;
+		y = 0;
+		++line;
+		while (in.read(block.data(), block.size()) || in.gcount() > 0)
+		{
+			const std::size_t size {static_cast<std::size_t>(in.gcount())};
+			for (std::size_t i {}; i < size; ++i)
+			{
+				const char c {block[i]};
+				if (c >= '0' && c <= '9')
+				{
+					// no board is wider or higher than uint32_t anyway
+					if (count > 100000000)
+					{
+						return parsed::UNREADABLE;
+					}
+					count = count * 10 + static_cast<uint32_t>(c - '0');
+					continue;
+				}
+				const uint32_t run {std::max(count, 1u)};
+				count = 0;
+				// runs are checked against what is left of the row, so the sum cannot wrap around
+				const bool fits {y < height && x <= width && run <= width - x};
+				if (c == 'b' || c == '.')
+				{
+					if (!fits)
+					{
+						return parsed::OUT_OF_RANGE;
+					}
+					x += run;
+				}
+				else if (c == '$')
+				{
+					if (y >= height || run > height - y)
+					{
+						return parsed::OUT_OF_RANGE;
+					}
+					x = 0;
+					y += run;
+				}
+				else if (c == '!')
+				{
+					return parsed::OK;
+				}
+				// capitals after A are dying states of Generations rules, which must have that many states
+				else if (r.states > 2 && c > 'A' && c <= 'Z')
+				{
+					const uint32_t state {static_cast<uint32_t>(c - 'A') + 1};
+					if (state >= r.states)
+					{
+						return parsed::UNREADABLE;
+					}
+					if (!fits)
+					{
+						return parsed::OUT_OF_RANGE;
+					}
+					for (uint32_t i {}; i < run; ++i)
+					{
+						p.dying.set(x + i, y, state);
+					}
+					x += run;
+				}
+				// o is alive, A too under Generations rules, which write their states as letters
+				else if (c == 'o' || (r.states > 2 && c == 'A'))
+				{
+					if (!fits)
+					{
+						return parsed::OUT_OF_RANGE;
+					}
+					fill(p.cells, x, y, run);
+					x += run;
+				}
+				else if (c == '\n')
+				{
+					++line;
+				}
+				else if (!std::isspace(static_cast<unsigned char>(c)))
+				{
+					return parsed::UNREADABLE;
+				}
+			}
+		}
+		// pattern without the final ! is taken as it is
+		return parsed::OK;
+	}
+	
+	void write_rle(std::ostream & out, const grid & world, const decay & dying, const std::string_view rule)
+	{
+		out << "x = " << world.width() << ", y = " << world.height() << ", rule = " << rule << '\n';
+		// lines of the body are kept within 70 characters, as the format asks
+		std::string line;
+		auto put {[&out, &line](uint32_t count, char tag)
+			{
+				std::string item {count > 1 ? std::to_string(count) : std::string {}};
+				item += tag;
+				if (line.size() + item.size() > 70)
+				{
+					out << line << '\n';
+					line.clear();
+				}
+				line += item;
+			}};
+		// states of Generations rules are letters, the others keep the usual b and o
+		const bool generations {dying.planes() != 0};
+		const std::string_view tags {generations ? ".ABCDEFGH" : "bo"};
+		auto state {[&world, &dying](uint32_t x, uint32_t y) -> uint32_t
+			{
+				return world.get(x, y) ? 1 : dying.get(x, y);
+			}};
+		// ends of rows and dead runs are held back until living or dying cells follow,
+		// so empty rows and dead cells at the end of a row cost nothing
+		uint32_t ends {};
+		for (uint32_t y {}; y < world.height(); ++y)
+		{
+			uint32_t dead {};
+			for (uint32_t x {}; x < world.width(); )
+			{
+				const uint32_t s {state(x, y)};
+				uint32_t end {x + 1};
+				while (end < world.width() && state(end, y) == s)
+				{
+					++end;
+				}
+				if (s != 0)
+				{
+					if (ends != 0)
+					{
+						put(ends, '$');
+						ends = 0;
+					}
+					if (dead != 0)
+					{
+						put(dead, tags[0]);
+						dead = 0;
+					}
+					put(end - x, tags[s]);
+				}
+				else
+				{
+					dead = end - x;
+				}
+				x = end;
+			}
+			++ends;
+		}
+		line += '!';
+		out << line << '\n';
+	}
+	
+	void place(const grid & cells, grid & world, uint32_t left, uint32_t top)
+	{
+		for (uint32_t y {}; y < cells.height() && top + y < world.height(); ++y)
+		{
+			for (uint32_t x {}; x < cells.width() && left + x < world.width(); ++x)
+			{
+				if (cells.get(x, y))
+				{
+					world.set(left + x, top + y, true);
+				}
+			}
+		}
+	}
+	
+	void place(const decay & cells, decay & world, uint32_t left, uint32_t top)
+	{
+		if (cells.planes() == 0)
+		{
+			return;
+		}
+		for (uint32_t y {}; y < cells.plane(0).height() && top + y < world.plane(0).height(); ++y)
+		{
+			for (uint32_t x {}; x < cells.plane(0).width() && left + x < world.plane(0).width(); ++x)
+			{
+				if (const uint32_t state {cells.get(x, y)}; state != 0)
+				{
+					world.set(left + x, top + y, state);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+//
+//  patterns.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include "pool.h"
+#include "decay.h"
+#include <string>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include <string_view>
+
+namespace game
+{
+	// first generation of a game and the rule it is played by as named in the file, empty if the file names none;
+	// dying cells have planes only if the file names a Generations rule
+	struct pattern
+	{
+		grid cells;
+		std::string rule;
+		decay dying;
+	};
+	
+	enum class parsed : uint32_t
+	{
+		OK,
+		UNREADABLE,
+		OUT_OF_RANGE,
+		UNSUPPORTED_RULE
+	};
+	
+	// patterns of the presets menu numbered as there: 2 glider gun, 3 spaceship, 4 oscillator, 5 six bits
+	pattern preset(uint32_t number);
+	// reads either format below, told apart by their first characters; x and y are left at the last coordinates read
+	// and line at the line they were on, counted from 1, so the wrong ones can be reported
+	parsed read_pattern(const std::string_view text, pattern & p, uint32_t & x, uint32_t & y, uint64_t & line, pool & workers);
+	// height and width of the world on the first line followed by a line of Y and X for every living cell;
+	// large files are split into as many parts as there are workers and parsed in parallel
+	parsed read_coordinates(const std::string_view text, pattern & p, uint32_t & x, uint32_t & y, uint64_t & line, pool & workers);
+	// run length encoded pattern: comment lines starting with #, the header "x = m, y = n, rule = B3/S23"
+	// and runs of dead (b) and alive (o) cells with rows ended by $ and the pattern by !;
+	// Generations rules name their states with letters, dead (.), alive (A) and dying ones from B on
+	parsed read_rle(std::istream & in, pattern & p, uint32_t & x, uint32_t & y, uint64_t & line);
+	void write_rle(std::ostream & out, const grid & world, const decay & dying, const std::string_view rule);
+	// copies cells of the pattern into the world with its top left corner at left and top
+	void place(const grid & cells, grid & world, uint32_t left, uint32_t top);
+	void place(const decay & cells, decay & world, uint32_t left, uint32_t top);
+}
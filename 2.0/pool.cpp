@@ -0,0 +1,119 @@
+//
+//  pool.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "pool.h"
+
+namespace
+{
+	uint64_t pack(uint32_t first, uint32_t end)
+	{
+		return (uint64_t {end} << 32) | first;
+	}
+}
+
+namespace game
+{
+	pool::pool(uint32_t size) : m_quit(false),
+	                            m_task(nullptr),
+	                            m_start(size ? size : 1),
+	                            m_finish(size ? size : 1)
+	{
+		for (uint32_t i {1}; i < size; ++i)
+		{
+			m_threads.emplace_back(&pool::work, this, i);
+		}
+	}
+	
+	pool::~pool()
+	{
+		// barrier publishes the flag to the workers waiting for the next task
+		m_quit = true;
+		m_start.arrive_and_wait();
+		for (auto & thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+	
+	uint32_t pool::size() const
+	{
+		return static_cast<uint32_t>(m_threads.size()) + 1;
+	}
+	
+	void pool::run(const std::function<void(uint32_t)> & task)
+	{
+		m_task = &task;
+		m_start.arrive_and_wait();
+		task(0);
+		m_finish.arrive_and_wait();
+		m_task = nullptr;
+	}
+	
+	void pool::work(uint32_t index)
+	{
+		while (true)
+		{
+			m_start.arrive_and_wait();
+			if (m_quit)
+			{
+				break;
+			}
+			(*m_task)(index);
+			m_finish.arrive_and_wait();
+		}
+	}
+	
+	shares::shares(uint32_t workers, uint32_t count) : m_workers(workers ? workers : 1),
+	                                                   m_ranges(std::make_unique<range[]>(m_workers))
+	{
+		for (uint32_t i {}; i < m_workers; ++i)
+		{
+			m_ranges[i].bounds.store(pack(static_cast<uint32_t>(uint64_t {count} * i / m_workers),
+			                              static_cast<uint32_t>(uint64_t {count} * (i + 1) / m_workers)), std::memory_order_relaxed);
+		}
+	}
+	
+	bool shares::take(uint32_t worker, uint32_t & item)
+	{
+		std::atomic<uint64_t> & own {m_ranges[worker].bounds};
+		uint64_t bounds {own.load(std::memory_order_relaxed)};
+		while (static_cast<uint32_t>(bounds) < static_cast<uint32_t>(bounds >> 32))
+		{
+			const uint32_t first {static_cast<uint32_t>(bounds)};
+			if (own.compare_exchange_weak(bounds, pack(first + 1, static_cast<uint32_t>(bounds >> 32)), std::memory_order_acq_rel))
+			{
+				item = first;
+				return true;
+			}
+		}
+		return steal(worker, item);
+	}
+	
+	// the thief keeps the first item stolen and puts the rest in its own range, which is empty meanwhile,
+	// so other thieves find nothing there until it is stored
+	bool shares::steal(uint32_t worker, uint32_t & item)
+	{
+		for (uint32_t i {1}; i < m_workers; ++i)
+		{
+			std::atomic<uint64_t> & other {m_ranges[(worker + i) % m_workers].bounds};
+			uint64_t bounds {other.load(std::memory_order_acquire)};
+			while (static_cast<uint32_t>(bounds) < static_cast<uint32_t>(bounds >> 32))
+			{
+				const uint32_t first {static_cast<uint32_t>(bounds)};
+				const uint32_t end {static_cast<uint32_t>(bounds >> 32)};
+				const uint32_t middle {first + (end - first) / 2};
+				if (other.compare_exchange_weak(bounds, pack(first, middle), std::memory_order_acq_rel))
+				{
+					item = middle;
+					m_ranges[worker].bounds.store(pack(middle + 1, end), std::memory_order_release);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+}
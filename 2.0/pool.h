@@ -0,0 +1,62 @@
+//
+//  pool.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <barrier>
+#include <cstdint>
+#include <functional>
+
+namespace game
+{
+	// persistent workers stepping a generation together; the calling thread is worker 0,
+	// the rest sleep on a barrier between generations instead of being created every time
+	class pool
+	{
+	public:
+		explicit pool(uint32_t size);
+		~pool();
+		pool(const pool &) = delete;
+		pool & operator = (const pool &) = delete;
+		uint32_t size() const;
+		// runs task(index) on every worker and returns when all of them are done
+		void run(const std::function<void(uint32_t)> & task);
+	private:
+		void work(uint32_t index);
+	private:
+		bool m_quit;
+		const std::function<void(uint32_t)> * m_task;
+		std::barrier<> m_start;
+		std::barrier<> m_finish;
+		std::vector<std::thread> m_threads;
+	};
+	
+	// items [0, count) shared out between workers for jobs of uneven length: every worker starts with an equal
+	// range and takes items from its front, one that runs out steals the back half of the range of another,
+	// so workers meet only when one of them is idle instead of on every item
+	class shares
+	{
+	public:
+		shares(uint32_t workers, uint32_t count);
+		// next item for the worker, false once there is none left anywhere
+		bool take(uint32_t worker, uint32_t & item);
+	private:
+		// first and end of a range in the low and high half of a word, so both change in one step;
+		// ranges of different workers are on cache lines of their own
+		struct alignas(64) range
+		{
+			std::atomic<uint64_t> bounds;
+		};
+		bool steal(uint32_t worker, uint32_t & item);
+	private:
+		const uint32_t m_workers;
+		std::unique_ptr<range[]> m_ranges;
+	};
+}
@@ -0,0 +1,105 @@
+//
+//  rule.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "rule.h"
+#include <cctype>
+#include <charconv>
+
+namespace
+{
+	// digits 0 to 8 as bits of a mask, each at most once
+	bool read_counts(std::string_view digits, uint16_t & mask)
+	{
+		mask = 0;
+		for (char c : digits)
+		{
+			if (c < '0' || c > '8' || (mask >> (c - '0')) & 1)
+			{
+				return false;
+			}
+			mask |= static_cast<uint16_t>(1 << (c - '0'));
+		}
+		return true;
+	}
+}
+
+namespace game
+{
+	bool parse_rule(const std::string_view text, rule & r)
+	{
+		std::string name;
+		for (char c : text)
+		{
+			name += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+		}
+		const std::size_t slash {name.find('/')};
+		if (slash == std::string::npos)
+		{
+			return false;
+		}
+		std::string_view first {name};
+		std::string_view second {first.substr(slash + 1)};
+		first = first.substr(0, slash);
+		// number of states of Generations rules comes last, with or without C in front of it
+		r.states = 2;
+		const std::size_t third {second.find('/')};
+		if (third != std::string_view::npos)
+		{
+			std::string_view states {second.substr(third + 1)};
+			second = second.substr(0, third);
+			if (states.starts_with('C'))
+			{
+				states.remove_prefix(1);
+			}
+			const auto [end, error] {std::from_chars(states.data(), states.data() + states.size(), r.states)};
+			if (error != std::errc {} || end != states.data() + states.size() || r.states < 2 || r.states > max_states)
+			{
+				return false;
+			}
+		}
+		// B/S names both parts, S/B names none of them or both the other way round
+		bool valid {};
+		if (first.starts_with('B') && second.starts_with('S'))
+		{
+			valid = read_counts(first.substr(1), r.birth) && read_counts(second.substr(1), r.survival);
+		}
+		else if (first.starts_with('S') && second.starts_with('B'))
+		{
+			valid = read_counts(first.substr(1), r.survival) && read_counts(second.substr(1), r.birth);
+		}
+		else
+		{
+			valid = read_counts(first, r.survival) && read_counts(second, r.birth);
+		}
+		return valid && (r.birth & 1) == 0;
+	}
+	
+	std::string rule_name(const rule & r)
+	{
+		std::string name {"B"};
+		for (uint32_t n {}; n < 9; ++n)
+		{
+			if ((r.birth >> n) & 1)
+			{
+				name += static_cast<char>('0' + n);
+			}
+		}
+		name += "/S";
+		for (uint32_t n {}; n < 9; ++n)
+		{
+			if ((r.survival >> n) & 1)
+			{
+				name += static_cast<char>('0' + n);
+			}
+		}
+		if (r.states > 2)
+		{
+			name += "/C" + std::to_string(r.states);
+		}
+		return name;
+	}
+}
@@ -0,0 +1,52 @@
+//
+//  rule.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+namespace game
+{
+	// life-like rule: bit n of birth is set if a dead cell with n neighbours comes alive,
+	// bit n of survival if a living cell with n neighbours stays alive;
+	// Generations rules have more than two states, a living cell that does not survive passes through
+	// states 2 to states - 1 before it is dead, it is neither counted as a neighbour nor born again meanwhile
+	struct rule
+	{
+		uint16_t birth;
+		uint16_t survival;
+		uint8_t states;
+		friend bool operator == (const rule & lhs, const rule & rhs) = default;
+	};
+	
+	// states of a cell are kept in at most 4 bits, so Generations rules have up to 9 of them
+	inline constexpr uint32_t max_states {9};
+	
+	// rules the kernels are compiled for, any other one is played through a table
+	inline constexpr rule conway {0b000001000, 0b000001100, 2};				// B3/S23
+	inline constexpr rule highlife {0b001001000, 0b000001100, 2};			// B36/S23
+	inline constexpr rule day_and_night {0b111001000, 0b111011000, 2};		// B3678/S34678
+	inline constexpr rule seeds {0b000000100, 0b000000000, 2};				// B2/S
+	
+	// Generations rules, Brian's Brain is played by the kernel of Seeds
+	inline constexpr rule brians_brain {0b000000100, 0b000000000, 3};		// B2/S/C3
+	inline constexpr rule star_wars {0b000000100, 0b000111000, 4};			// B2/S345/C4
+	
+	// births and survivals of a rule without its dying states, the part the step kernels play
+	constexpr rule life_like(const rule & r)
+	{
+		return {r.birth, r.survival, 2};
+	}
+	
+	// B/S notation like B36/S23 or the older S/B one like 23/36 or S23/B36, in either case, followed by /C and
+	// the number of states for Generations rules, like B2/S/C3 or /2/3; rules with B0 are not played,
+	// since they would bring the whole unbounded plane to life in a single generation
+	bool parse_rule(const std::string_view text, rule & r);
+	// name of the rule in B/S notation
+	std::string rule_name(const rule & r);
+}
@@ -0,0 +1,427 @@
+//
+//  screen.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "screen.h"
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#ifdef _WIN32
+#include <io.h>
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace
+{
+	// pen before the first cell of a frame, matches no state of a cell
+	constexpr uint32_t no_pen {game::max_states};
+	// cursor movement is ESC [ row ; column H with numbers of up to 10 digits
+	constexpr std::size_t cursor_size {24};
+	// dots of braille characters by column and row, as bits of the code added to U+2800
+	constexpr uint8_t braille_dots[2][4] {{0x01, 0x02, 0x04, 0x40}, {0x08, 0x10, 0x20, 0x80}};
+	
+	// geometry of the zoom levels: characters taken by one character of the board,
+	// dots in one character and cells in one dot along each side
+	uint32_t character_width(uint32_t zoom)
+	{
+		return zoom == 0 ? 2 : 1;
+	}
+	
+	uint32_t dots_x(uint32_t zoom)
+	{
+		return zoom < 2 ? 1 : 2;
+	}
+	
+	uint32_t dots_y(uint32_t zoom)
+	{
+		return zoom == 0 ? 1 : (zoom == 1 ? 2 : 4);
+	}
+	
+	uint32_t scale(uint32_t zoom)
+	{
+		return zoom < 3 ? 1 : 1u << (zoom - 2);
+	}
+	
+	uint8_t dot(uint32_t zoom, uint32_t x, uint32_t y)
+	{
+		return zoom < 2 ? static_cast<uint8_t>(1u << y) : braille_dots[x][y];
+	}
+	
+	// zeros if output is not a terminal
+	void terminal_size(uint32_t & columns, uint32_t & rows)
+	{
+		columns = 0;
+		rows = 0;
+#ifdef _WIN32
+		CONSOLE_SCREEN_BUFFER_INFO info {};
+		if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+		{
+			columns = static_cast<uint32_t>(info.srWindow.Right - info.srWindow.Left + 1);
+			rows = static_cast<uint32_t>(info.srWindow.Bottom - info.srWindow.Top + 1);
+		}
+#else
+		winsize size {};
+		if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0)
+		{
+			columns = size.ws_col;
+			rows = size.ws_row;
+		}
+#endif
+	}
+}
+
+namespace game
+{
+	colour operator ++ (colour & c)
+	{
+		uint32_t n {static_cast<uint32_t>(c)};
+		return (n == 37 ? c = colour::BLACK : c = static_cast<colour>(n + 1));
+	}
+	
+	bool operator == (colour lhs, colour rhs)
+	{
+		return static_cast<uint32_t>(lhs) == static_cast<uint32_t>(rhs);
+	}
+	
+	screen::screen() : m_symbol("██"),
+	                   m_halves({" ", "▀", "▄", "█"}),
+	                   m_length(),
+	                   m_valid(false),
+	                   m_zoom(),
+	                   m_columns(),
+	                   m_rows(),
+	                   m_alive(),
+	                   m_dead(),
+	                   m_states(),
+	                   m_pen(no_pen)
+	{
+		// braille patterns are U+2800 to U+28FF, three bytes each in UTF-8
+		for (uint32_t code {}; code < m_braille.size(); ++code)
+		{
+			m_braille[code] = {static_cast<char>(0xe2), static_cast<char>(0xa0 + (code >> 6)), static_cast<char>(0x80 + (code & 63))};
+		}
+	}
+	
+	void screen::clear()
+	{
+		m_length = 0;
+	}
+	
+	void screen::invalidate()
+	{
+		m_valid = false;
+	}
+	
+	void screen::draw(const grid & world, const decay & dying, const view & v, colour alive, colour dead)
+	{
+		if (world.width() == 0 || world.height() == 0)
+		{
+			return;
+		}
+		// glyphs are made again only when colours or the rule change, not for every frame;
+		// dying states take the bright colours following the one of alive cells
+		if (alive != m_alive || dead != m_dead || dying.states() != m_states || m_glyphs[0].empty())
+		{
+			m_glyphs[0] = std::format("{}{}", dead, m_symbol);
+			m_glyphs[1] = std::format("{}{}", alive, m_symbol);
+			for (uint32_t state {2}; state < dying.states(); ++state)
+			{
+				m_glyphs[state] = std::format("\u001b[{}m{}", 90 + (static_cast<uint32_t>(alive) - 30 + state - 1) % 8, m_symbol);
+			}
+			m_alive = alive;
+			m_dead = dead;
+			m_states = dying.states();
+			m_valid = false;
+		}
+		const uint32_t left {std::min(v.left, world.width() - 1)};
+		const uint32_t top {std::min(v.top, world.height() - 1)};
+		const uint32_t cells_x {dots_x(v.zoom) * scale(v.zoom)};
+		const uint32_t cells_y {dots_y(v.zoom) * scale(v.zoom)};
+		uint32_t columns {(world.width() - left + cells_x - 1) / cells_x};
+		uint32_t rows {(world.height() - top + cells_y - 1) / cells_y};
+		// size is not known if output is not a terminal, the whole board is shown then;
+		// two lines below the board are left for the status and the input
+		uint32_t width {};
+		uint32_t height {};
+		terminal_size(width, height);
+		if (width != 0)
+		{
+			columns = std::min(columns, std::max(width / character_width(v.zoom), 1u));
+		}
+		if (height != 0)
+		{
+			rows = std::min(rows, std::max(height, 3u) - 2);
+		}
+		if (v.zoom != m_zoom || columns != m_columns || rows != m_rows)
+		{
+			m_zoom = v.zoom;
+			m_columns = columns;
+			m_rows = rows;
+			m_codes.resize(static_cast<std::size_t>(columns) * rows);
+			m_shown.resize(m_codes.size());
+			m_valid = false;
+		}
+		sample(world, left, top);
+		if (m_zoom == 0 && dying.planes() != 0)
+		{
+			sample(dying, left, top);
+		}
+		// every character may need its own colour escape, every row a cursor movement and a line break
+		std::size_t glyph {};
+		for (const std::string & g : m_glyphs)
+		{
+			glyph = std::max(glyph, g.size());
+		}
+		reserve(static_cast<std::size_t>(rows) * (columns * glyph + cursor_size + 1) + 3 * cursor_size);
+		// line below the board ends with colour reset, so every frame starts with the default colour
+		m_pen = no_pen;
+		if (m_valid)
+		{
+			update();
+		}
+		else
+		{
+			redraw();
+		}
+		m_shown.swap(m_codes);
+		m_valid = true;
+	}
+	
+	std::string_view screen::text() const
+	{
+		return {m_text.data(), m_length};
+	}
+	
+	void screen::show() const
+	{
+		// whatever menus left in the buffer of stdout must be on the terminal before the frame
+		fflush(stdout);
+		for (std::size_t written {}; written < m_length; )
+		{
+#ifdef _WIN32
+			const auto result {_write(1, m_text.data() + written, static_cast<unsigned int>(m_length - written))};
+#else
+			const auto result {::write(STDOUT_FILENO, m_text.data() + written, m_length - written)};
+#endif
+			if (result <= 0)
+			{
+				break;
+			}
+			written += static_cast<std::size_t>(result);
+		}
+	}
+	
+	// makes room for size more bytes after the frame
+	void screen::reserve(std::size_t size)
+	{
+		if (m_length + size > m_text.size())
+		{
+			m_text.resize(std::max(m_length + size, m_text.size() * 2));
+		}
+	}
+	
+	// callers reserve the room beforehand
+	void screen::put(const std::string_view text)
+	{
+		std::memcpy(m_text.data() + m_length, text.data(), text.size());
+		m_length += text.size();
+	}
+	
+	void screen::put(uint32_t number)
+	{
+		char * const begin {m_text.data() + m_length};
+		m_length += static_cast<std::size_t>(std::to_chars(begin, begin + 10, number).ptr - begin);
+	}
+	
+	// codes of the characters of the board, a dot is set if any cell of its block is alive
+	void screen::sample(const grid & world, uint32_t left, uint32_t top)
+	{
+		const uint32_t size {scale(m_zoom)};
+		m_line.resize(world.stride());
+		std::fill(m_codes.begin(), m_codes.end(), 0);
+		for (uint32_t y {}; y < m_rows; ++y)
+		{
+			uint8_t * codes {m_codes.data() + static_cast<std::size_t>(y) * m_columns};
+			for (uint32_t j {}; j < dots_y(m_zoom); ++j)
+			{
+				const uint32_t first_row {top + (y * dots_y(m_zoom) + j) * size};
+				if (first_row >= world.height())
+				{
+					break;
+				}
+				// rows of the block are merged word by word, only words under the screen are touched
+				const uint32_t last_row {std::min(first_row + size, world.height())};
+				const uint32_t last_cell {std::min(left + m_columns * dots_x(m_zoom) * size, world.width())};
+				const uint64_t * line {world.row(first_row)};
+				if (last_row - first_row > 1)
+				{
+					std::fill(m_line.begin(), m_line.end(), 0);
+					for (uint32_t row {first_row}; row < last_row; ++row)
+					{
+						for (uint32_t i {left >> 6}; i <= (last_cell - 1) >> 6; ++i)
+						{
+							m_line[i] |= world.row(row)[i];
+						}
+					}
+					line = m_line.data();
+				}
+				for (uint32_t x {}; x < m_columns; ++x)
+				{
+					for (uint32_t i {}; i < dots_x(m_zoom); ++i)
+					{
+						const uint32_t first_cell {left + (x * dots_x(m_zoom) + i) * size};
+						if (first_cell < world.width() && any(line, first_cell, std::min(first_cell + size, world.width())))
+						{
+							codes[x] |= dot(m_zoom, i, j);
+						}
+					}
+				}
+			}
+		}
+	}
+	
+	// states of dying cells under characters of a cell each that no living cell took
+	void screen::sample(const decay & dying, uint32_t left, uint32_t top)
+	{
+		const grid & plane {dying.plane(0)};
+		for (uint32_t y {}; y < m_rows && top + y < plane.height(); ++y)
+		{
+			uint8_t * codes {m_codes.data() + static_cast<std::size_t>(y) * m_columns};
+			for (uint32_t x {}; x < m_columns && left + x < plane.width(); ++x)
+			{
+				if (codes[x] == 0)
+				{
+					codes[x] = static_cast<uint8_t>(dying.get(left + x, top + y));
+				}
+			}
+		}
+	}
+	
+	// whether any of the bits [first, last) is set
+	bool screen::any(const uint64_t * line, uint32_t first, uint32_t last) const
+	{
+		for (uint32_t x {first}; x < last; )
+		{
+			const uint32_t end {std::min(last, (x | 63) + 1)};
+			const uint32_t count {end - x};
+			const uint64_t mask {count == 64 ? ~uint64_t {} : (uint64_t {1} << count) - 1};
+			if ((line[x >> 6] >> (x & 63)) & mask)
+			{
+				return true;
+			}
+			x = end;
+		}
+		return false;
+	}
+	
+	// zoomed out characters are drawn in the colour of alive cells on the background of dead ones
+	void screen::palette()
+	{
+		put("\u001b[");
+		put(static_cast<uint32_t>(m_alive));
+		put(";");
+		put(static_cast<uint32_t>(m_dead) + 10);
+		put("m");
+	}
+	
+	void screen::redraw()
+	{
+		// rows follow each other, the cursor is not moved to them
+		m_valid = false;
+		put("\u001b[2J\u001b[H");
+		if (m_zoom != 0)
+		{
+			palette();
+		}
+		for (uint32_t y {}; y < m_rows; ++y)
+		{
+			characters(y, 0, m_columns);
+			put("\n");
+		}
+	}
+	
+	void screen::update()
+	{
+		if (m_zoom != 0)
+		{
+			palette();
+		}
+		// moving the cursor costs about as much as writing a couple of characters, so short gaps are written through
+		constexpr uint32_t gap {2};
+		for (uint32_t y {}; y < m_rows; ++y)
+		{
+			const uint8_t * now {m_codes.data() + static_cast<std::size_t>(y) * m_columns};
+			const uint8_t * before {m_shown.data() + static_cast<std::size_t>(y) * m_columns};
+			uint32_t first {};
+			uint32_t last {};
+			for (uint32_t x {}; x < m_columns; ++x)
+			{
+				if (now[x] == before[x])
+				{
+					continue;
+				}
+				if (last != 0 && x > last + gap)
+				{
+					characters(y, first, last);
+					last = 0;
+				}
+				if (last == 0)
+				{
+					first = x;
+				}
+				last = x + 1;
+			}
+			if (last != 0)
+			{
+				characters(y, first, last);
+			}
+		}
+		put("\u001b[");
+		put(m_rows + 1);
+		put(";1H\u001b[J");
+	}
+	
+	// writes characters [first, last) of row y, in place if the cursor has to be moved there;
+	// rows and columns of the terminal start at 1
+	void screen::characters(uint32_t y, uint32_t first, uint32_t last)
+	{
+		if (m_valid)
+		{
+			put("\u001b[");
+			put(y + 1);
+			put(";");
+			put(first * character_width(m_zoom) + 1);
+			put("H");
+		}
+		const uint8_t * codes {m_codes.data() + static_cast<std::size_t>(y) * m_columns};
+		for (uint32_t x {first}; x < last; ++x)
+		{
+			if (m_zoom == 1)
+			{
+				put(m_halves[codes[x]]);
+			}
+			else if (m_zoom > 1)
+			{
+				put(m_braille[codes[x]]);
+			}
+			// colour escape only where it changes, runs of cells of the same state share it
+			else if (codes[x] != m_pen)
+			{
+				put(m_glyphs[codes[x]]);
+				m_pen = codes[x];
+			}
+			else
+			{
+				put(m_symbol);
+			}
+		}
+	}
+}
@@ -0,0 +1,119 @@
+//
+//  screen.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include "decay.h"
+#include "rule.h"
+#include <array>
+#include <string>
+#include <vector>
+#include <utility>
+#include <format>
+#include <cstdint>
+#include <string_view>
+
+namespace game
+{
+	enum class colour : uint32_t
+	{
+		DEFAULT	= 0,
+		BLACK	= 30,
+		RED		= 31,
+		GREEN	= 32,
+		YELLOW	= 33,
+		BLUE	= 34,
+		MAGENTA = 35,
+		CYAN	= 36,
+		WHITE	= 37
+	};
+	
+	colour operator ++ (colour & c);
+	bool operator == (colour lhs, colour rhs);
+	
+	// part of the world shown on the screen
+	struct view
+	{
+		uint32_t left;												// cell in the top left corner of the screen
+		uint32_t top;
+		uint32_t zoom;												// 0 is a cell per two characters, 1 half blocks of 1x2 cells,
+																	// 2 braille of 2x4 cells, every next one doubles the cells per dot
+	};
+	
+	// text of one frame printed to the terminal: the board first, then the lines below it;
+	// only the part of the world that fits the terminal is shown, so the cost of a frame follows the screen;
+	// characters are compared with the ones drawn before, and only runs of changed ones are written
+	// with the cursor moved to them, the whole screen is drawn again only when it could be out of date;
+	// the frame is built in a buffer that only grows, so once it is large enough a frame allocates nothing
+	class screen
+	{
+	public:
+		screen();
+		void clear();
+		// the next board is drawn whole, used when something else was printed on the terminal
+		void invalidate();
+		// writes the board and leaves the cursor on the line below it with the rest of the screen erased;
+		// dying cells of Generations rules are drawn one by one only, every state in a colour of its own
+		void draw(const grid & world, const decay & dying, const view & v, colour alive, colour dead);
+		template <typename ... Args>
+		void write(std::format_string<Args ...> format, Args && ... args);
+		std::string_view text() const;
+		// prints the frame with a single write to the terminal
+		void show() const;
+	private:
+		void reserve(std::size_t size);
+		void put(const std::string_view text);
+		void put(uint32_t number);
+		void sample(const grid & world, uint32_t left, uint32_t top);
+		void sample(const decay & dying, uint32_t left, uint32_t top);
+		bool any(const uint64_t * line, uint32_t first, uint32_t last) const;
+		void palette();
+		void redraw();
+		void update();
+		void characters(uint32_t y, uint32_t first, uint32_t last);
+	private:
+		const std::string m_symbol;
+		std::array<std::string, max_states> m_glyphs;				// colour escape and symbol of every state of a cell
+		std::array<std::string, 4> m_halves;						// top and bottom cells as bits 0 and 1
+		std::array<std::string, 256> m_braille;						// dots of unicode braille as bits
+		std::vector<char> m_text;
+		std::size_t m_length;										// bytes of m_text taken by the frame
+		bool m_valid;												// terminal shows m_shown drawn in m_alive and m_dead
+		uint32_t m_zoom;
+		uint32_t m_columns;											// characters of the board on the screen
+		uint32_t m_rows;
+		std::vector<uint8_t> m_codes;								// cells under every character of the board as bits,
+																	// a cell per character has its state instead
+		std::vector<uint8_t> m_shown;
+		std::vector<uint64_t> m_line;								// rows of a block merged together
+		colour m_alive;
+		colour m_dead;
+		uint32_t m_states;											// states the glyphs were made for
+		uint32_t m_pen;												// state of the cells written last, their glyph sets the colour
+	};
+	
+	template <typename ... Args>
+	void screen::write(std::format_string<Args ...> format, Args && ... args)
+	{
+		const std::size_t size {std::formatted_size(format, args ...)};
+		reserve(size);
+		std::format_to_n(m_text.data() + m_length, size, format, std::forward<Args>(args) ...);
+		m_length += size;
+	}
+}
+
+// std::formatter specialization for colour class
+// must be defined out of game namespace
+template <>
+struct std::formatter<game::colour> : std::formatter<std::string_view>
+{
+	template <typename T>
+	auto format(game::colour c, T & t)
+	{
+		return std::formatter<std::string_view>::format("\u001b[" + std::to_string(static_cast<uint32_t>(c)) + "m", t);
+	}
+};
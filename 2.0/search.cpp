@@ -0,0 +1,220 @@
+//
+//  search.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "search.h"
+#include "kernel.h"
+#include "history.h"
+#include "generator.h"
+#include <bit>
+#include <vector>
+
+namespace
+{
+	// soup of one lane of the packed worlds, the generation it is at and the hashes of the ones before;
+	// a repeated hash makes its rows a candidate, which is a cycle only if they come back a period later
+	struct lane
+	{
+		lane(uint32_t limit, uint32_t height) : generation(), active(false), past(limit), rows(height), due(), period(), start()
+		{
+			
+		}
+		
+		uint64_t generation;
+		bool active;
+		game::history past;
+		std::vector<uint64_t> rows;									// rows of the candidate
+		uint64_t due;												// generation the candidate is checked at, zero if none
+		uint64_t period;
+		uint64_t start;												// generation the cycle began at
+	};
+	
+	// hash and population of the soup in lane i
+	void measure(const std::vector<uint64_t> & words, uint32_t i, uint32_t height, uint64_t & hash, uint64_t & population)
+	{
+		hash = 0;
+		population = 0;
+		for (uint32_t y {}; y < height; ++y)
+		{
+			const uint64_t row {words[static_cast<std::size_t>(y) * game::soup_lanes + i]};
+			hash ^= game::word_hash(y, row);
+			population += std::popcount(row);
+		}
+	}
+	
+	// copies the rows of the soup in lane i or compares them with the copy
+	void copy(const std::vector<uint64_t> & words, uint32_t i, std::vector<uint64_t> & rows)
+	{
+		for (std::size_t y {}; y < rows.size(); ++y)
+		{
+			rows[y] = words[y * game::soup_lanes + i];
+		}
+	}
+	
+	bool same(const std::vector<uint64_t> & words, uint32_t i, const std::vector<uint64_t> & rows)
+	{
+		for (std::size_t y {}; y < rows.size(); ++y)
+		{
+			if (rows[y] != words[y * game::soup_lanes + i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	void record(game::search_results & result, uint64_t lifespan, uint64_t population)
+	{
+		++result.soups;
+		++result.lifespans[std::bit_width(lifespan)];
+		++result.populations[std::bit_width(population)];
+		result.population += population;
+	}
+}
+
+namespace game
+{
+	search_results & search_results::operator += (const search_results & other)
+	{
+		soups += other.soups;
+		extinct += other.extinct;
+		capped += other.capped;
+		generations += other.generations;
+		population += other.population;
+		for (std::size_t i {}; i < lifespans.size(); ++i)
+		{
+			lifespans[i] += other.lifespans[i];
+			populations[i] += other.populations[i];
+		}
+		for (const auto & [period, soups] : other.periods)
+		{
+			periods[period] += soups;
+		}
+		return *this;
+	}
+	
+	search_results search(const settings & options, pool & workers)
+	{
+		const uint32_t width {options.width != 0 ? options.width : 16};
+		const uint32_t height {options.height != 0 ? options.height : 16};
+		const uint64_t mask {~uint64_t {} >> (64 - width)};
+		const kernel rule {options.rules};
+		shares work {workers.size(), options.soups};
+		std::vector<search_results> results(workers.size());
+		workers.run([&](uint32_t index)
+		{
+			search_results & result {results[index]};
+			std::vector<uint64_t> src(static_cast<std::size_t>(height) * soup_lanes);
+			std::vector<uint64_t> dst(src.size());
+			std::vector<lane> lanes;
+			for (uint32_t i {}; i < soup_lanes; ++i)
+			{
+				lanes.emplace_back(options.period, height);
+			}
+			// puts the next soup in lane i, soups that start empty are done at once; false when there is none left
+			auto start {[&](uint32_t i) -> bool
+				{
+					uint32_t item {};
+					while (work.take(index, item))
+					{
+						generator random {options.seed, item};
+						for (uint32_t y {}; y < height; ++y)
+						{
+							src[static_cast<std::size_t>(y) * soup_lanes + i] = random.cells(options.density) & mask;
+						}
+						uint64_t hash {};
+						uint64_t population {};
+						measure(src, i, height, hash, population);
+						if (population == 0)
+						{
+							record(result, 0, 0);
+							++result.extinct;
+							continue;
+						}
+						lanes[i].generation = 0;
+						lanes[i].due = 0;
+						lanes[i].past.clear();
+						lanes[i].past.add(hash, 0);
+						return true;
+					}
+					for (uint32_t y {}; y < height; ++y)
+					{
+						src[static_cast<std::size_t>(y) * soup_lanes + i] = 0;
+					}
+					return false;
+				}};
+			uint32_t active {};
+			for (uint32_t i {}; i < soup_lanes; ++i)
+			{
+				lanes[i].active = start(i);
+				active += lanes[i].active;
+			}
+			while (active != 0)
+			{
+				rule.step_soups(src.data(), dst.data(), width, height);
+				src.swap(dst);
+				for (uint32_t i {}; i < soup_lanes; ++i)
+				{
+					lane & l {lanes[i]};
+					if (!l.active)
+					{
+						continue;
+					}
+					++l.generation;
+					++result.generations;
+					uint64_t hash {};
+					uint64_t population {};
+					measure(src, i, height, hash, population);
+					// a repeated hash is confirmed by stepping the soup a period further and comparing the rows,
+					// as the game does, so a collision of hashes is never counted as a cycle
+					if (population != 0)
+					{
+						// every generation is added, so steps of the history stay generations
+						const history::match m {l.past.add(hash, l.generation)};
+						if (l.due == l.generation && !same(src, i, l.rows))
+						{
+							l.due = 0;
+						}
+						else if (l.due == 0 && m.steps != 0)
+						{
+							copy(src, i, l.rows);
+							l.due = l.generation + m.steps;
+							l.period = m.steps;
+							l.start = m.generation;
+						}
+					}
+					if (population == 0)
+					{
+						record(result, l.generation, 0);
+						++result.extinct;
+					}
+					else if (l.due != 0 && l.due == l.generation)
+					{
+						record(result, l.start, population);
+						++result.periods[l.period];
+					}
+					else if (l.generation == options.cap)
+					{
+						record(result, l.generation, population);
+						++result.capped;
+					}
+					else
+					{
+						continue;
+					}
+					l.active = start(i);
+					active -= !l.active;
+				}
+			}
+		});
+		search_results total {};
+		for (const search_results & part : results)
+		{
+			total += part;
+		}
+		return total;
+	}
+}
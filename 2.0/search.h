@@ -0,0 +1,39 @@
+//
+//  search.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "pool.h"
+#include "settings.h"
+#include <map>
+#include <array>
+#include <cstdint>
+
+namespace game
+{
+	// what became of the soups of a search: how long they lived before they died out or settled into a cycle,
+	// the populations they were left with and the periods of their cycles, 1 for still lifes;
+	// histograms count soups by powers of two, bucket n holds values from 2^(n - 1) to 2^n - 1
+	struct search_results
+	{
+		uint64_t soups;
+		uint64_t extinct;
+		uint64_t capped;											// still changing at the last generation allowed
+		uint64_t generations;										// stepped over all the soups
+		uint64_t population;										// left over all the soups
+		std::array<uint64_t, 65> lifespans;							// generation the final state started at
+		std::array<uint64_t, 65> populations;
+		std::map<uint64_t, uint64_t> periods;						// soups by the period of their cycle
+		search_results & operator += (const search_results & other);
+	};
+	
+	// steps options.soups random tori of options.width x options.height, 16x16 if not given, with options.density
+	// percent of living cells until each one dies out, repeats an earlier generation within options.period steps
+	// or reaches options.cap generations; soup number k follows from the seed and k alone, so the results
+	// are the same whatever the number of threads; soups are packed soup_lanes at a time for the vector units
+	// and each worker refills a lane as soon as its soup ends, taking soups from a work-stealing share
+	search_results search(const settings & options, pool & workers);
+}
@@ -0,0 +1,259 @@
+//
+//  settings.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "settings.h"
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+
+namespace
+{
+	template <typename T>
+	bool to_number(const std::string_view string, T & value)
+	{
+		auto [end, error] {std::from_chars(string.data(), string.data() + string.size(), value)};
+		return error == std::errc {} && end == string.data() + string.size();
+	}
+}
+
+namespace game
+{
+	settings::settings() : threads(std::max(std::thread::hardware_concurrency(), 1u)),
+	                       mode(engine::TORUS),
+	                       step_exponent(),
+	                       cache_megabytes(1024),
+	                       preset(),
+	                       width(),
+	                       height(),
+	                       rate(2),
+	                       fps(30),
+	                       generations(),
+	                       format(report::JSON),
+	                       interval(60),
+	                       period(1000),
+	                       rules(conway),
+	                       soups(),
+	                       seed(std::random_device {}()),
+	                       density(30),
+	                       cap(10000)
+	{
+		
+	}
+	
+	std::string_view engine_name(engine mode)
+	{
+		switch (mode)
+		{
+			case engine::HASHLIFE:
+			{
+				return "hashlife";
+			}
+			case engine::SPARSE:
+			{
+				return "sparse";
+			}
+			default:
+			{
+				return "torus";
+			}
+		}
+	}
+	
+	bool parse_settings(int argc, const char * argv[], settings & options)
+	{
+		for (int i {1}; i < argc; ++i)
+		{
+			const std::string_view arg {argv[i]};
+			// every option except the filename takes a value
+			if (arg.starts_with("--") && i + 1 == argc)
+			{
+				return false;
+			}
+			if (arg == "--threads")
+			{
+				if (!to_number(argv[++i], options.threads) || options.threads == 0)
+				{
+					return false;
+				}
+			}
+			else if (arg == "--engine")
+			{
+				const std::string_view name {argv[++i]};
+				if (name == "torus")
+				{
+					options.mode = engine::TORUS;
+				}
+				else if (name == "hashlife")
+				{
+					options.mode = engine::HASHLIFE;
+				}
+				else if (name == "sparse")
+				{
+					options.mode = engine::SPARSE;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			// 2^50 generations at once keeps the quadtree within 64-bit coordinates
+			else if (arg == "--step")
+			{
+				if (!to_number(argv[++i], options.step_exponent) || options.step_exponent > 50)
+				{
+					return false;
+				}
+			}
+			else if (arg == "--cache")
+			{
+				if (!to_number(argv[++i], options.cache_megabytes) || options.cache_megabytes == 0)
+				{
+					return false;
+				}
+			}
+			// numbers of the presets menu: 1 random, 2 glider gun, 3 spaceship, 4 oscillator, 5 six bits
+			else if (arg == "--preset")
+			{
+				if (!to_number(argv[++i], options.preset) || options.preset < 1 || options.preset > 5)
+				{
+					return false;
+				}
+			}
+			// size of the random world written as WIDTHxHEIGHT
+			else if (arg == "--size")
+			{
+				const std::string_view size {argv[++i]};
+				const std::size_t x {size.find('x')};
+				if (x == std::string_view::npos || !to_number(size.substr(0, x), options.width) ||
+				    !to_number(size.substr(x + 1), options.height) || options.width == 0 || options.height == 0 ||
+				    options.width > max_side || options.height > max_side)
+				{
+					return false;
+				}
+			}
+			else if (arg == "--rate")
+			{
+				if (!to_number(argv[++i], options.rate))
+				{
+					return false;
+				}
+			}
+			// terminals do not keep up with more than a few hundred frames per second anyway
+			else if (arg == "--fps")
+			{
+				if (!to_number(argv[++i], options.fps) || options.fps == 0 || options.fps > 1000)
+				{
+					return false;
+				}
+			}
+			else if (arg == "--bench")
+			{
+				if (!to_number(argv[++i], options.generations) || options.generations == 0)
+				{
+					return false;
+				}
+			}
+			else if (arg == "--format")
+			{
+				const std::string_view name {argv[++i]};
+				if (name == "json")
+				{
+					options.format = report::JSON;
+				}
+				else if (name == "csv")
+				{
+					options.format = report::CSV;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			else if (arg == "--checkpoint")
+			{
+				options.checkpoint = argv[++i];
+			}
+			else if (arg == "--timings")
+			{
+				options.timings = argv[++i];
+			}
+			else if (arg == "--interval")
+			{
+				if (!to_number(argv[++i], options.interval) || options.interval == 0)
+				{
+					return false;
+				}
+			}
+			// every step within the period is remembered in two tables of 24-byte entries at most half full,
+			// 2^20 steps take about 100 MB
+			else if (arg == "--period")
+			{
+				if (!to_number(argv[++i], options.period) || options.period == 0 || options.period > (1u << 20))
+				{
+					return false;
+				}
+			}
+			else if (arg == "--rule")
+			{
+				if (!parse_rule(argv[++i], options.rules))
+				{
+					return false;
+				}
+			}
+			else if (arg == "--search")
+			{
+				if (!to_number(argv[++i], options.soups) || options.soups == 0)
+				{
+					return false;
+				}
+			}
+			else if (arg == "--seed")
+			{
+				if (!to_number(argv[++i], options.seed))
+				{
+					return false;
+				}
+			}
+			else if (arg == "--density")
+			{
+				if (!to_number(argv[++i], options.density) || options.density > 100)
+				{
+					return false;
+				}
+			}
+			else if (arg == "--cap")
+			{
+				if (!to_number(argv[++i], options.cap) || options.cap == 0)
+				{
+					return false;
+				}
+			}
+			else if (!arg.starts_with("--") && options.filename.empty())
+			{
+				options.filename = arg;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		// soups are packed a row to a word, so they are at most 64 cells wide
+		if (options.soups != 0 && (options.width > 64 || options.rules.states != 2 || options.mode != engine::TORUS))
+		{
+			return false;
+		}
+		// snapshots hold a world of a fixed size, the unbounded engines would lose all but their window
+		if (!options.checkpoint.empty() && options.mode != engine::TORUS)
+		{
+			return false;
+		}
+		// unbounded engines keep living cells only, dying ones of Generations rules need the torus
+		return options.rules.states == 2 || options.mode == engine::TORUS;
+	}
+}
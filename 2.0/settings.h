@@ -0,0 +1,63 @@
+//
+//  settings.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "rule.h"
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace game
+{
+	enum class engine : uint32_t
+	{
+		TORUS,														// fixed size world wrapping around at the edges
+		HASHLIFE,													// unbounded plane, moves 2^step_exponent generations at once
+		SPARSE														// unbounded plane stored only where cells are alive
+	};
+	
+	enum class report : uint32_t
+	{
+		JSON,
+		CSV
+	};
+	
+	// longest side of a world given by --size or read from a snapshot
+	inline constexpr uint32_t max_side {1u << 20};
+	
+	// options given on the command line
+	struct settings
+	{
+		settings();
+		std::string filename;										// pattern to start with, menu is shown if empty
+		uint32_t threads;											// workers stepping the world, all hardware threads by default
+		engine mode;
+		uint32_t step_exponent;
+		uint64_t cache_megabytes;									// memory for HashLife nodes before garbage collection
+		uint32_t preset;											// pattern of the menu to start with if no file is given, 0 shows the menu
+		uint32_t width;												// size of the random world, chosen at random if 0
+		uint32_t height;
+		uint32_t rate;												// generations per second, 0 runs them as fast as possible
+		uint32_t fps;												// frames per second drawn on the terminal
+		uint64_t generations;										// headless run of this many generations, 0 starts the game
+		report format;												// how results of the headless run are written
+		std::string checkpoint;										// snapshot of the game saved now and then, none if empty
+		uint32_t interval;											// seconds between checkpoints
+		std::string timings;										// times of the phases written here on exit, none if empty
+		uint32_t period;											// longest cycle of generations looked for, in steps
+		rule rules;													// rule of random and preset worlds, files name their own
+		uint32_t soups;												// random worlds of a soup search run instead of the game
+		uint64_t seed;												// random worlds and soups follow from it alone, random unless given
+		uint32_t density;											// percent of living cells in random worlds and soups
+		uint64_t cap;												// generations a soup is stepped at most
+	};
+	
+	std::string_view engine_name(engine mode);
+	
+	// fills settings from command line arguments, returns false if any of them is wrong
+	bool parse_settings(int argc, const char * argv[], settings & options);
+}
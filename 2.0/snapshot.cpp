@@ -0,0 +1,390 @@
+//
+//  snapshot.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "snapshot.h"
+#include "rule.h"
+#include "settings.h"
+#include <bit>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#ifdef _WIN32
+// std::min and std::max are used below
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr std::string_view magic {"LIFESNAP"};
+	constexpr uint32_t version {1};
+	// magic, version, width, height, length of the rule and generation
+	constexpr std::size_t header_size {8 + 4 * 4 + 8};
+	
+	void put(std::string & data, uint64_t value, std::size_t bytes)
+	{
+		for (std::size_t i {}; i < bytes; ++i)
+		{
+			data += static_cast<char>(value >> (i * 8));
+		}
+	}
+	
+	uint64_t take(const char * data, std::size_t bytes)
+	{
+		uint64_t value {};
+		for (std::size_t i {}; i < bytes; ++i)
+		{
+			value |= uint64_t {static_cast<uint8_t>(data[i])} << (i * 8);
+		}
+		return value;
+	}
+	
+	// words are copied as they are on little-endian hosts, which all the supported ones are
+	void store(char * data, uint64_t word)
+	{
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			std::memcpy(data, &word, sizeof(word));
+		}
+		else
+		{
+			for (std::size_t i {}; i < sizeof(word); ++i)
+			{
+				data[i] = static_cast<char>(word >> (i * 8));
+			}
+		}
+	}
+	
+	uint64_t load(const char * data)
+	{
+		uint64_t word {};
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			std::memcpy(&word, data, sizeof(word));
+		}
+		else
+		{
+			word = take(data, sizeof(word));
+		}
+		return word;
+	}
+	
+	// data written to the file and flushed to the disk before the function returns, so a rename after it
+	// never makes a file visible whose contents are still only in the cache
+	bool write_through(const std::string & filename, const std::string_view data)
+	{
+#ifdef _WIN32
+		const HANDLE file {CreateFileA(filename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)};
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		DWORD written {};
+		const bool done {WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) &&
+		                 written == data.size() && FlushFileBuffers(file)};
+		return CloseHandle(file) && done;
+#else
+		const int file {open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+		if (file < 0)
+		{
+			return false;
+		}
+		bool done {true};
+		for (std::size_t offset {}; done && offset < data.size(); )
+		{
+			const ssize_t written {write(file, data.data() + offset, data.size() - offset)};
+			done = written > 0;
+			offset += done ? static_cast<std::size_t>(written) : 0;
+		}
+		done = done && fsync(file) == 0;
+		return close(file) == 0 && done;
+#endif
+	}
+	
+	// replaces the file with the temporary one and makes the new directory entry durable as well
+	bool replace(const std::string & temporary, const std::string & filename)
+	{
+#ifdef _WIN32
+		return MoveFileExA(temporary.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+		if (rename(temporary.c_str(), filename.c_str()) != 0)
+		{
+			return false;
+		}
+		// file systems that cannot sync a directory have the rename on the disk anyway
+		const std::filesystem::path directory {std::filesystem::path {filename}.parent_path()};
+		const int handle {open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY)};
+		if (handle >= 0)
+		{
+			fsync(handle);
+			close(handle);
+		}
+		return true;
+#endif
+	}
+	
+	// eight bytes at a time, enough to tell a damaged or cut file from a good one
+	uint64_t checksum(const std::string_view data)
+	{
+		uint64_t h {0x9e3779b97f4a7c15};
+		std::size_t i {};
+		for (; i + 8 <= data.size(); i += 8)
+		{
+			h = (h ^ load(data.data() + i)) * 0xff51afd7ed558ccd;
+			h ^= h >> 29;
+		}
+		for (; i < data.size(); ++i)
+		{
+			h = (h ^ static_cast<uint8_t>(data[i])) * 0xff51afd7ed558ccd;
+			h ^= h >> 29;
+		}
+		return h;
+	}
+	
+	// rows follow each other without gaps, so the whole grid is one array of words;
+	// a bit for each word tells if it holds living cells, only those words are stored after the bits
+	void write_grid(std::string & data, const game::grid & cells)
+	{
+		const std::size_t count {static_cast<std::size_t>(cells.stride()) * cells.height()};
+		const std::size_t masks {(count + 63) / 64};
+		const uint64_t * words {count != 0 ? cells.row(0) : nullptr};
+		const std::size_t start {data.size()};
+		data.resize(start + (masks + count) * sizeof(uint64_t));
+		char * mask_out {data.data() + start};
+		char * word_out {mask_out + masks * sizeof(uint64_t)};
+		for (std::size_t m {}; m < masks; ++m)
+		{
+			uint64_t mask {};
+			const std::size_t last {std::min(count, m * 64 + 64)};
+			for (std::size_t i {m * 64}; i < last; ++i)
+			{
+				if (words[i] != 0)
+				{
+					mask |= uint64_t {1} << (i & 63);
+					store(word_out, words[i]);
+					word_out += sizeof(uint64_t);
+				}
+			}
+			store(mask_out, mask);
+			mask_out += sizeof(uint64_t);
+		}
+		data.resize(static_cast<std::size_t>(word_out - data.data()));
+	}
+	
+	// fills a grid of the right size from in, which is left after its last word; end is where the data ends
+	bool read_grid(const char * & in, const char * end, game::grid & cells)
+	{
+		const std::size_t count {static_cast<std::size_t>(cells.stride()) * cells.height()};
+		const std::size_t masks {(count + 63) / 64};
+		uint64_t * words {count != 0 ? cells.row(0) : nullptr};
+		if (masks > static_cast<std::size_t>(end - in) / sizeof(uint64_t))
+		{
+			return false;
+		}
+		const char * word_in {in + masks * sizeof(uint64_t)};
+		const std::size_t stored {static_cast<std::size_t>(end - word_in) / sizeof(uint64_t)};
+		std::size_t taken {};
+		for (std::size_t m {}; m < masks; ++m)
+		{
+			uint64_t mask {load(in + m * sizeof(uint64_t))};
+			// bits past the last word and more words than stored mean a broken file
+			const std::size_t last {std::min<std::size_t>(count - m * 64, 64)};
+			if ((last < 64 && mask >> last != 0) || static_cast<std::size_t>(std::popcount(mask)) > stored - taken)
+			{
+				return false;
+			}
+			for (; mask != 0; mask &= mask - 1)
+			{
+				words[m * 64 + std::countr_zero(mask)] = load(word_in + taken * sizeof(uint64_t));
+				++taken;
+			}
+		}
+		in = word_in + taken * sizeof(uint64_t);
+		// bits past the width must stay zero whatever the file says
+		if (cells.width() % 64 != 0)
+		{
+			for (uint32_t y {}; y < cells.height(); ++y)
+			{
+				cells.row(y)[cells.stride() - 1] &= (uint64_t {1} << (cells.width() % 64)) - 1;
+			}
+		}
+		return true;
+	}
+}
+
+namespace game
+{
+	bool is_snapshot(const std::string_view data)
+	{
+		return data.starts_with(magic);
+	}
+	
+	void write_snapshot(std::string & data, const snapshot & s)
+	{
+		data.clear();
+		data += magic;
+		put(data, version, 4);
+		put(data, s.cells.width(), 4);
+		put(data, s.cells.height(), 4);
+		put(data, s.rule.size(), 4);
+		put(data, s.generation, 8);
+		data += s.rule;
+		write_grid(data, s.cells);
+		for (uint32_t i {}; i < s.dying.planes(); ++i)
+		{
+			write_grid(data, s.dying.plane(i));
+		}
+		put(data, checksum(data), 8);
+	}
+	
+	parsed read_snapshot(const std::string_view data, snapshot & s)
+	{
+		if (!is_snapshot(data) || data.size() < header_size + 8)
+		{
+			return parsed::UNREADABLE;
+		}
+		const std::string_view body {data.substr(0, data.size() - 8)};
+		if (checksum(body) != take(body.data() + body.size(), 8) || take(data.data() + 8, 4) != version)
+		{
+			return parsed::UNREADABLE;
+		}
+		const uint32_t width {static_cast<uint32_t>(take(data.data() + 12, 4))};
+		const uint32_t height {static_cast<uint32_t>(take(data.data() + 16, 4))};
+		const std::size_t length {take(data.data() + 20, 4)};
+		if (header_size + length > body.size())
+		{
+			return parsed::UNREADABLE;
+		}
+		s.rule = body.substr(header_size, length);
+		rule r {};
+		if (!parse_rule(s.rule, r))
+		{
+			return parsed::UNSUPPORTED_RULE;
+		}
+		// sizes are checked before anything is allocated: every grid needs at least its bits, even with no word stored
+		const std::size_t words {static_cast<std::size_t>((width + 63) / 64) * height};
+		const std::size_t grids {1 + static_cast<std::size_t>(std::bit_width(r.states - 2u))};
+		if (width == 0 || height == 0 || width > max_side || height > max_side ||
+		    (words + 63) / 64 * grids > (body.size() - header_size - length) / sizeof(uint64_t))
+		{
+			return parsed::UNREADABLE;
+		}
+		s.generation = take(data.data() + 24, 8);
+		s.cells.resize(width, height);
+		s.dying.resize(width, height, r.states);
+		const char * in {body.data() + header_size + length};
+		if (!read_grid(in, body.data() + body.size(), s.cells))
+		{
+			return parsed::UNREADABLE;
+		}
+		for (uint32_t i {}; i < s.dying.planes(); ++i)
+		{
+			if (!read_grid(in, body.data() + body.size(), s.dying.plane(i)))
+			{
+				return parsed::UNREADABLE;
+			}
+		}
+		if (in != body.data() + body.size())
+		{
+			return parsed::UNREADABLE;
+		}
+		return parsed::OK;
+	}
+	
+	bool save_snapshot(const std::string & filename, const snapshot & s)
+	{
+		std::string data;
+		write_snapshot(data, s);
+		const std::string temporary {filename + ".tmp"};
+		return write_through(temporary, data) && replace(temporary, filename);
+	}
+	
+	checkpoint::checkpoint(const std::string & filename, std::chrono::seconds interval) : m_filename(filename),
+	                                                                                      m_interval(interval),
+	                                                                                      m_saved(std::chrono::steady_clock::now()),
+	                                                                                      m_busy(false),
+	                                                                                      m_quit(false),
+	                                                                                      m_pending({grid {}, 0, {}, {}}),
+	                                                                                      m_thread(&checkpoint::work, this)
+	{
+		
+	}
+	
+	checkpoint::~checkpoint()
+	{
+		{
+			std::lock_guard<std::mutex> lk(m_mutex);
+			m_quit = true;
+		}
+		m_interaction.notify_all();
+		m_thread.join();
+	}
+	
+	void checkpoint::offer(const grid & world, const decay & dying, uint64_t generation, const std::string_view rule)
+	{
+		// called for every generation, so the game never waits here: a writer holding the lock means it is busy anyway
+		std::unique_lock<std::mutex> lk(m_mutex, std::try_to_lock);
+		const auto now {std::chrono::steady_clock::now()};
+		if (!lk.owns_lock() || m_busy || now - m_saved < m_interval)
+		{
+			return;
+		}
+		m_pending.cells = world;
+		m_pending.dying = dying;
+		m_pending.generation = generation;
+		m_pending.rule = rule;
+		m_saved = now;
+		m_busy = true;
+		lk.unlock();
+		m_interaction.notify_all();
+	}
+	
+	bool checkpoint::save(const grid & world, const decay & dying, uint64_t generation, const std::string_view rule)
+	{
+		std::unique_lock<std::mutex> lk(m_mutex);
+		m_interaction.wait(lk, [this]() -> bool
+		{
+			return !m_busy;
+		});
+		m_pending.cells = world;
+		m_pending.dying = dying;
+		m_pending.generation = generation;
+		m_pending.rule = rule;
+		m_saved = std::chrono::steady_clock::now();
+		return save_snapshot(m_filename, m_pending);
+	}
+	
+	void checkpoint::work()
+	{
+		std::unique_lock<std::mutex> lk(m_mutex);
+		while (true)
+		{
+			m_interaction.wait(lk, [this]() -> bool
+			{
+				return m_busy || m_quit;
+			});
+			// snapshot handed over before quitting is still written
+			if (m_busy)
+			{
+				lk.unlock();
+				// failed checkpoint is tried again after the next interval, the previous file stays as it was
+				save_snapshot(m_filename, m_pending);
+				lk.lock();
+				m_busy = false;
+				m_interaction.notify_all();
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,67 @@
+//
+//  snapshot.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include "decay.h"
+#include "patterns.h"
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <string_view>
+#include <condition_variable>
+
+namespace game
+{
+	// state of a running game saved to be resumed later
+	struct snapshot
+	{
+		grid cells;
+		uint64_t generation;
+		std::string rule;
+		decay dying;
+	};
+	
+	// binary format, all numbers little-endian: "LIFESNAP", version, width, height, length of the rule, generation,
+	// the rule, the grid and a checksum of everything before it; the grid is a bit for every word telling
+	// if it holds living cells, followed by those words only, so empty parts of the world take almost no space;
+	// Generations rules have the planes of dying cells after the grid, each stored the same way
+	bool is_snapshot(const std::string_view data);
+	void write_snapshot(std::string & data, const snapshot & s);
+	parsed read_snapshot(const std::string_view data, snapshot & s);
+	// written to a temporary file, synced to the disk and renamed over the old one, so neither a crash
+	// nor a power loss leaves a broken snapshot
+	bool save_snapshot(const std::string & filename, const snapshot & s);
+	
+	// snapshots of the game saved now and then on a thread of its own, so the game goes on while the disk is busy
+	class checkpoint
+	{
+	public:
+		checkpoint(const std::string & filename, std::chrono::seconds interval);
+		~checkpoint();
+		checkpoint(const checkpoint &) = delete;
+		checkpoint & operator = (const checkpoint &) = delete;
+		// copies the world for the writer if the interval has passed and the previous snapshot is written
+		void offer(const grid & world, const decay & dying, uint64_t generation, const std::string_view rule);
+		// saves the world at once, after the snapshot being written if there is one
+		bool save(const grid & world, const decay & dying, uint64_t generation, const std::string_view rule);
+	private:
+		void work();
+	private:
+		const std::string m_filename;
+		const std::chrono::seconds m_interval;
+		std::chrono::steady_clock::time_point m_saved;
+		bool m_busy;													// writer has a snapshot to save, guarded by m_mutex
+		bool m_quit;
+		snapshot m_pending;												// copy of the world the writer saves, kept to reuse its memory
+		std::mutex m_mutex;
+		std::condition_variable m_interaction;
+		std::thread m_thread;
+	};
+}
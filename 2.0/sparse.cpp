@@ -0,0 +1,261 @@
+//
+//  sparse.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "sparse.h"
+#include "kernel.h"
+#include <bit>
+#include <algorithm>
+
+namespace
+{
+	// marks a chunk that was stepped and turned out empty, so it is not stepped again
+	constexpr uint32_t dead_chunk {0xfffffffe};
+	
+	inline uint64_t mix(uint64_t h)
+	{
+		h = (h ^ (h >> 33)) * 0xff51afd7ed558ccd;
+		h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53;
+		return h ^ (h >> 33);
+	}
+}
+
+namespace game
+{
+	sparse::table::table() : m_keys(1024), m_values(1024, none), m_size()
+	{
+		
+	}
+	
+	void sparse::table::clear()
+	{
+		std::fill(m_values.begin(), m_values.end(), none);
+		m_size = 0;
+	}
+	
+	uint32_t sparse::table::find(uint64_t key) const
+	{
+		const uint64_t mask {m_keys.size() - 1};
+		for (uint64_t i {mix(key) & mask}; m_values[i] != none; i = (i + 1) & mask)
+		{
+			if (m_keys[i] == key)
+			{
+				return m_values[i];
+			}
+		}
+		return none;
+	}
+	
+	void sparse::table::insert(uint64_t key, uint32_t value)
+	{
+		// keep the table at most half full, so probe sequences stay short
+		if ((m_size + 1) * 2 > m_keys.size())
+		{
+			std::vector<uint64_t> keys(m_keys.size() * 2);
+			std::vector<uint32_t> values(m_values.size() * 2, none);
+			keys.swap(m_keys);
+			values.swap(m_values);
+			m_size = 0;
+			for (std::size_t i {}; i < keys.size(); ++i)
+			{
+				if (values[i] != none)
+				{
+					insert(keys[i], values[i]);
+				}
+			}
+		}
+		const uint64_t mask {m_keys.size() - 1};
+		uint64_t i {mix(key) & mask};
+		while (m_values[i] != none)
+		{
+			i = (i + 1) & mask;
+		}
+		m_keys[i] = key;
+		m_values[i] = value;
+		++m_size;
+	}
+	
+	sparse::sparse() : m_rule(conway),
+	                   m_population()
+	{
+		
+	}
+	
+	void sparse::clear(const rule & r)
+	{
+		m_rule = r;
+		m_chunks.clear();
+		m_index.clear();
+		m_population = 0;
+	}
+	
+	void sparse::set(int64_t x, int64_t y)
+	{
+		// arithmetic shift rounds negative coordinates down to their chunk
+		const int32_t cx {static_cast<int32_t>(x >> 6)};
+		const int32_t cy {static_cast<int32_t>(y >> 6)};
+		uint32_t index {m_index.find(key(cx, cy))};
+		if (index == table::none)
+		{
+			index = static_cast<uint32_t>(m_chunks.size());
+			m_chunks.push_back({cx, cy, {}});
+			m_index.insert(key(cx, cy), index);
+		}
+		uint64_t & row {m_chunks[index].rows[y & 63]};
+		const uint64_t mask {uint64_t {1} << (x & 63)};
+		if (!(row & mask))
+		{
+			row |= mask;
+			++m_population;
+		}
+	}
+	
+	void sparse::advance()
+	{
+		with_rule(m_rule, [this](const auto & rule)
+		{
+			advance(rule);
+		});
+	}
+	
+	template <typename Rule>
+	void sparse::advance(const Rule & rule)
+	{
+		m_next.clear();
+		m_next_index.clear();
+		m_population = 0;
+		for (std::size_t i {}; i < m_chunks.size(); ++i)
+		{
+			const chunk & c {m_chunks[i]};
+			evolve(rule, c.x, c.y);
+			// births outside the chunk are only possible next to its edges that hold living cells
+			const bool north {c.rows.front() != 0};
+			const bool south {c.rows.back() != 0};
+			bool west {false};
+			bool east {false};
+			for (uint64_t row : c.rows)
+			{
+				west |= row & 1;
+				east |= row >> 63;
+			}
+			if (north) { evolve(rule, c.x, c.y - 1); }
+			if (south) { evolve(rule, c.x, c.y + 1); }
+			if (west) { evolve(rule, c.x - 1, c.y); }
+			if (east) { evolve(rule, c.x + 1, c.y); }
+			if (north && west) { evolve(rule, c.x - 1, c.y - 1); }
+			if (north && east) { evolve(rule, c.x + 1, c.y - 1); }
+			if (south && west) { evolve(rule, c.x - 1, c.y + 1); }
+			if (south && east) { evolve(rule, c.x + 1, c.y + 1); }
+		}
+		m_chunks.swap(m_next);
+		// index is built anew, since chunks found empty must not be seen as existing
+		m_index.clear();
+		for (uint32_t i {}; i < m_chunks.size(); ++i)
+		{
+			m_index.insert(key(m_chunks[i].x, m_chunks[i].y), i);
+		}
+	}
+	
+	uint64_t sparse::step() const
+	{
+		return 1;
+	}
+	
+	uint64_t sparse::population() const
+	{
+		return m_population;
+	}
+	
+	void sparse::read(grid & window, int64_t left, int64_t top) const
+	{
+		window.clear();
+		for (const chunk & c : m_chunks)
+		{
+			const int64_t x0 {int64_t {c.x} * 64};
+			const int64_t y0 {int64_t {c.y} * 64};
+			if (x0 + 64 <= left || y0 + 64 <= top || x0 >= left + window.width() || y0 >= top + window.height())
+			{
+				continue;
+			}
+			for (uint32_t j {}; j < 64; ++j)
+			{
+				const int64_t y {y0 + j - top};
+				if (y < 0 || y >= window.height())
+				{
+					continue;
+				}
+				for (uint64_t row {c.rows[j]}; row != 0; row &= row - 1)
+				{
+					const int64_t x {x0 + std::countr_zero(row) - left};
+					if (x >= 0 && x < window.width())
+					{
+						window.set(static_cast<uint32_t>(x), static_cast<uint32_t>(y), true);
+					}
+				}
+			}
+		}
+	}
+	
+	uint64_t sparse::key(int32_t x, int32_t y)
+	{
+		return (uint64_t {static_cast<uint32_t>(x)} << 32) | static_cast<uint32_t>(y);
+	}
+	
+	const sparse::chunk * sparse::find(int32_t x, int32_t y) const
+	{
+		const uint32_t index {m_index.find(key(x, y))};
+		return index == table::none ? nullptr : &m_chunks[index];
+	}
+	
+	// steps chunk at X and Y into the next generation, unless it was already done
+	template <typename Rule>
+	void sparse::evolve(const Rule & rule, int32_t x, int32_t y)
+	{
+		if (m_next_index.find(key(x, y)) != table::none)
+		{
+			return;
+		}
+		// 3x3 chunks around, missing ones are dead
+		static const chunk nothing {};
+		const chunk * around[3][3];
+		for (int32_t j {-1}; j < 2; ++j)
+		{
+			for (int32_t i {-1}; i < 2; ++i)
+			{
+				const chunk * c {find(x + i, y + j)};
+				around[j + 1][i + 1] = c ? c : &nothing;
+			}
+		}
+		// word of row r (-1 to 64) taken from chunks in column i, west and east neighbours line up with the cells
+		auto word {[&around](int32_t i, int32_t r) -> uint64_t
+			{
+				const int32_t j {r < 0 ? 0 : (r > 63 ? 2 : 1)};
+				return around[j][i]->rows[static_cast<uint32_t>(r + 64) & 63];
+			}};
+		chunk next {x, y, {}};
+		uint64_t population {};
+		for (int32_t r {}; r < 64; ++r)
+		{
+			uint64_t w[3], c[3], e[3];
+			for (int32_t k {}; k < 3; ++k)
+			{
+				c[k] = word(1, r + k - 1);
+				w[k] = (c[k] << 1) | (word(0, r + k - 1) >> 63);
+				e[k] = (c[k] >> 1) | (word(2, r + k - 1) << 63);
+			}
+			next.rows[r] = game::evolve(rule, w[0], c[0], e[0], w[1], c[1], e[1], w[2], c[2], e[2]);
+			population += std::popcount(next.rows[r]);
+		}
+		if (population == 0)
+		{
+			m_next_index.insert(key(x, y), dead_chunk);
+			return;
+		}
+		m_next_index.insert(key(x, y), static_cast<uint32_t>(m_next.size()));
+		m_next.push_back(next);
+		m_population += population;
+	}
+}
@@ -0,0 +1,63 @@
+//
+//  sparse.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "universe.h"
+#include <array>
+#include <vector>
+
+namespace game
+{
+	// unbounded plane made of 64x64 chunks kept only where cells are alive, so memory follows
+	// the population rather than the bounding box; chunks are found by their coordinates
+	// packed into a 64-bit key of an open addressing hash table
+	class sparse : public universe
+	{
+	public:
+		sparse();
+		void clear(const rule & r) override;
+		void set(int64_t x, int64_t y) override;
+		void advance() override;
+		uint64_t step() const override;
+		uint64_t population() const override;
+		void read(grid & window, int64_t left, int64_t top) const override;
+	private:
+		struct chunk
+		{
+			int32_t x;												// coordinates of the chunk, in chunks
+			int32_t y;
+			std::array<uint64_t, 64> rows;							// bit x of row y is cell at 64 * x + bit, 64 * y + row
+		};
+		class table
+		{
+		public:
+			static constexpr uint32_t none {0xffffffff};
+			table();
+			void clear();
+			uint32_t find(uint64_t key) const;
+			void insert(uint64_t key, uint32_t value);
+		private:
+			std::vector<uint64_t> m_keys;
+			std::vector<uint32_t> m_values;
+			uint32_t m_size;
+		};
+		static uint64_t key(int32_t x, int32_t y);
+		const chunk * find(int32_t x, int32_t y) const;
+		// both are made for the policy of a rule, see game::with_rule()
+		template <typename Rule>
+		void advance(const Rule & rule);
+		template <typename Rule>
+		void evolve(const Rule & rule, int32_t x, int32_t y);
+	private:
+		rule m_rule;
+		uint64_t m_population;
+		std::vector<chunk> m_chunks;
+		std::vector<chunk> m_next;
+		table m_index;
+		table m_next_index;											// also remembers chunks found empty in the generation being built
+	};
+}
@@ -0,0 +1,646 @@
+//
+//  tests.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "grid.h"
+#include "rule.h"
+#include "pool.h"
+#include "decay.h"
+#include "kernel.h"
+#include "kernel_simd.h"
+#include "sparse.h"
+#include "hashlife.h"
+#include "settings.h"
+#include "patterns.h"
+#include "snapshot.h"
+#include "generator.h"
+#include <bit>
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <sstream>
+#include <string_view>
+#include <initializer_list>
+
+// the engine is checked against a plain version of the rules that looks at every cell and its eight neighbours,
+// the file formats against what they write themselves and against broken files; every failed check is printed
+// and the run ends with 1 if there was one
+
+namespace
+{
+	uint32_t failures {};
+	
+	void check(bool passed, const std::string & what)
+	{
+		if (!passed)
+		{
+			fputs(std::format("FAILED: {}\n", what).c_str(), stderr);
+			++failures;
+		}
+	}
+	
+	game::rule named(const std::string_view text)
+	{
+		game::rule r {};
+		check(game::parse_rule(text, r), std::format("rule {} is read", text));
+		return r;
+	}
+	
+	// rules compiled into the kernels, rules played through a table and Generations rules
+	const std::vector<game::rule> & rules()
+	{
+		static const std::vector<game::rule> all {game::conway, game::highlife, game::day_and_night, game::seeds,
+		                                          named("B36/S125"), named("B1357/S02468"), named("B2/S/C3"), named("B2/S345/C4"),
+		                                          named("B3/S23/C9")};
+		return all;
+	}
+	
+	// a world as a state for every cell: 0 dead, 1 alive and from 2 on dying
+	struct cells
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<uint8_t> states;
+		uint8_t & at(uint32_t x, uint32_t y) { return states[static_cast<std::size_t>(y) * width + x]; }
+		uint8_t at(uint32_t x, uint32_t y) const { return states[static_cast<std::size_t>(y) * width + x]; }
+		friend bool operator == (const cells & lhs, const cells & rhs) = default;
+	};
+	
+	cells random_cells(uint32_t width, uint32_t height, uint32_t states, uint64_t seed, uint32_t density)
+	{
+		cells c {width, height, std::vector<uint8_t>(static_cast<std::size_t>(width) * height)};
+		game::generator random {seed};
+		for (uint8_t & state : c.states)
+		{
+			if (random.below(100) < density)
+			{
+				state = 1;
+			}
+			else if (states > 2 && random.below(4) == 0)
+			{
+				state = static_cast<uint8_t>(2 + random.below(states - 2));
+			}
+		}
+		return c;
+	}
+	
+	// next generation cell by cell, the world wraps around at all the edges
+	cells reference_step(const cells & c, const game::rule & r)
+	{
+		cells next {c.width, c.height, std::vector<uint8_t>(c.states.size())};
+		for (uint32_t y {}; y < c.height; ++y)
+		{
+			for (uint32_t x {}; x < c.width; ++x)
+			{
+				uint32_t n {};
+				// a world one cell wide or high is its own neighbour on both sides, as in the kernels
+				for (const int32_t dy : {-1, 0, 1})
+				{
+					for (const int32_t dx : {-1, 0, 1})
+					{
+						if (dx != 0 || dy != 0)
+						{
+							n += c.at((x + c.width + dx) % c.width, (y + c.height + dy) % c.height) == 1;
+						}
+					}
+				}
+				const uint8_t state {c.at(x, y)};
+				if (state == 0)
+				{
+					next.at(x, y) = (r.birth >> n) & 1;
+				}
+				else if (state == 1)
+				{
+					next.at(x, y) = (r.survival >> n) & 1 ? 1 : (r.states > 2 ? 2 : 0);
+				}
+				else
+				{
+					next.at(x, y) = state + 1u == r.states ? 0 : state + 1;
+				}
+			}
+		}
+		return next;
+	}
+	
+	void write_cells(const cells & c, game::grid & world, game::decay & dying, uint32_t states)
+	{
+		world.resize(c.width, c.height);
+		dying.resize(c.width, c.height, states);
+		for (uint32_t y {}; y < c.height; ++y)
+		{
+			for (uint32_t x {}; x < c.width; ++x)
+			{
+				world.set(x, y, c.at(x, y) == 1);
+				dying.set(x, y, c.at(x, y));
+			}
+		}
+	}
+	
+	cells read_cells(const game::grid & world, const game::decay & dying)
+	{
+		cells c {world.width(), world.height(), std::vector<uint8_t>(static_cast<std::size_t>(world.width()) * world.height())};
+		for (uint32_t y {}; y < c.height; ++y)
+		{
+			for (uint32_t x {}; x < c.width; ++x)
+			{
+				c.at(x, y) = static_cast<uint8_t>(world.get(x, y) ? 1 : dying.get(x, y));
+			}
+		}
+		return c;
+	}
+	
+	game::grid living(const cells & c)
+	{
+		game::grid world {c.width, c.height};
+		for (uint32_t y {}; y < c.height; ++y)
+		{
+			for (uint32_t x {}; x < c.width; ++x)
+			{
+				world.set(x, y, c.at(x, y) == 1);
+			}
+		}
+		return world;
+	}
+	
+	// kernel of the host, with the dying cells aged after it as the game does, over odd sizes and every rule;
+	// the changes reported by compare() must match the hashes and populations of the worlds
+	void test_kernel()
+	{
+		uint64_t seed {};
+		for (const game::rule & r : rules())
+		{
+			const game::kernel k {r};
+			for (const uint32_t width : {1u, 2u, 3u, 5u, 63u, 64u, 65u, 127u, 129u, 191u, 575u, 1031u})
+			{
+				for (const uint32_t height : {1u, 2u, 3u, 7u, 66u})
+				{
+					const std::string name {std::format("{} {}x{}", game::rule_name(r), width, height)};
+					cells expected {random_cells(width, height, r.states, ++seed, 35)};
+					game::grid before;
+					game::grid after;
+					game::decay dying;
+					write_cells(expected, before, dying, r.states);
+					for (uint32_t generation {1}; generation <= 3; ++generation)
+					{
+						expected = reference_step(expected, r);
+						after.resize(width, height);
+						k.step(before, after, 0, height);
+						if (dying.planes() != 0)
+						{
+							dying.step(before, after, 0, height);
+						}
+						game::changes total {};
+						for (uint32_t y {}; y < height; ++y)
+						{
+							total += game::compare(before, after, y, 0, before.stride());
+						}
+						check(read_cells(after, dying) == expected, std::format("kernel steps {} to generation {}", name, generation));
+						check((before.hash() ^ total.hash) == after.hash(), std::format("hash of {} follows generation {}", name, generation));
+						check(before.population() + total.births - total.deaths == after.population(),
+						      std::format("population of {} follows generation {}", name, generation));
+						std::swap(before, after);
+					}
+					// rows stepped in spans as the tiles do give the same words
+					const cells start {random_cells(width, height, 2, ++seed, 35)};
+					const game::grid src {living(start)};
+					game::grid whole {width, height};
+					game::grid spans {width, height};
+					k.step(src, whole, 0, height);
+					const uint32_t stride {src.stride()};
+					for (uint32_t y {}; y < height; ++y)
+					{
+						k.step_span(src, spans, y, 0, stride / 3);
+						k.step_span(src, spans, y, stride / 3, stride * 2 / 3);
+						k.step_span(src, spans, y, stride * 2 / 3, stride);
+					}
+					check(whole == spans, std::format("spans of {} step as whole rows", name));
+					check(whole == living(reference_step(start, game::life_like(r))), std::format("kernel steps living cells of {}", name));
+				}
+			}
+		}
+	}
+	
+	struct vector_isa
+	{
+		std::string_view name;
+		game::interior_kernel (* interior)(const game::rule & r);
+		game::simd::compare_kernel compare;
+		game::soup_kernel (* soups)(const game::rule & r);
+		game::decay_kernel (* decay)(uint32_t planes);
+	};
+	
+	std::vector<vector_isa> vector_isas()
+	{
+		std::vector<vector_isa> isas;
+#ifdef GAME_SIMD_X86
+		if (game::simd::has_avx2())
+		{
+			isas.push_back({"avx2", game::simd::interior_avx2, game::simd::compare_avx2, game::simd::soups_avx2, game::simd::decay_avx2});
+		}
+		if (game::simd::has_avx512())
+		{
+			isas.push_back({"avx512", game::simd::interior_avx512, game::simd::compare_avx512, game::simd::soups_avx512, game::simd::decay_avx512});
+		}
+#endif
+		return isas;
+	}
+	
+	// every vector kernel the host runs on its own, whichever of them the kernel class picked:
+	// the words they leave for the scalar code are not checked, the ones they write must be the reference ones
+	void test_vectors(const vector_isa & isa)
+	{
+		uint64_t seed {1000};
+		for (const game::rule & r : rules())
+		{
+			const game::rule counts {game::life_like(r)};
+			const game::table_rule table {counts};
+			const game::interior_kernel interior {isa.interior(counts)};
+			const cells start {random_cells(64 * 41 + 9, 4, 2, ++seed, 40)};
+			const game::grid src {living(start)};
+			const game::grid expected {living(reference_step(start, counts))};
+			const uint32_t stride {src.stride()};
+			for (uint32_t y {}; y < src.height(); ++y)
+			{
+				const uint64_t * top {src.row((y + src.height() - 1) % src.height())};
+				const uint64_t * bottom {src.row((y + 1) % src.height())};
+				for (const uint32_t first : {1u, 2u, 3u, 5u, 8u})
+				{
+					for (const uint32_t last : {stride - 1, stride - 4, first + 7})
+					{
+						std::vector<uint64_t> out(stride);
+						const uint32_t w {interior(top, src.row(y), bottom, out.data(), first, last, table)};
+						bool same {w >= first && w <= last};
+						for (uint32_t i {first}; same && i < w; ++i)
+						{
+							same = out[i] == expected.row(y)[i];
+						}
+						check(same, std::format("{} interior kernel of {} on words {} to {}", isa.name, game::rule_name(counts), first, last));
+					}
+				}
+			}
+			// packed soups of every width against the same soups one by one
+			const game::soup_kernel soups {isa.soups(counts)};
+			for (const uint32_t width : {1u, 7u, 16u, 31u, 64u})
+			{
+				for (const uint32_t height : {1u, 3u, 16u, 40u})
+				{
+					std::vector<cells> worlds;
+					std::vector<uint64_t> src(static_cast<std::size_t>(height) * game::soup_lanes);
+					for (uint32_t i {}; i < game::soup_lanes; ++i)
+					{
+						worlds.push_back(random_cells(width, height, 2, ++seed, 40));
+						const game::grid world {living(worlds.back())};
+						for (uint32_t y {}; y < height; ++y)
+						{
+							src[static_cast<std::size_t>(y) * game::soup_lanes + i] = world.row(y)[0];
+						}
+					}
+					std::vector<uint64_t> dst(src.size());
+					soups(src.data(), dst.data(), width, height, table);
+					bool same {true};
+					for (uint32_t i {}; i < game::soup_lanes; ++i)
+					{
+						const game::grid next {living(reference_step(worlds[i], counts))};
+						for (uint32_t y {}; y < height; ++y)
+						{
+							same = same && dst[static_cast<std::size_t>(y) * game::soup_lanes + i] == next.row(y)[0];
+						}
+					}
+					check(same, std::format("{} soup kernel of {} on {}x{}", isa.name, game::rule_name(counts), width, height));
+				}
+			}
+		}
+		// changes of a row against a word by word count, from several first words
+		game::generator random {++seed};
+		std::vector<uint64_t> before(67);
+		std::vector<uint64_t> after(before.size());
+		for (std::size_t i {}; i < before.size(); ++i)
+		{
+			before[i] = random.cells(30);
+			after[i] = i % 5 == 0 ? before[i] : random.cells(30);
+		}
+		for (const uint32_t first : {0u, 1u, 3u, 9u})
+		{
+			game::changes result {};
+			const uint32_t last {static_cast<uint32_t>(before.size())};
+			const uint32_t w {isa.compare(before.data(), after.data(), 1000, first, last, result)};
+			game::changes expected {};
+			for (uint32_t i {first}; i < w; ++i)
+			{
+				expected.hash ^= game::word_hash(1000 + i, before[i]) ^ game::word_hash(1000 + i, after[i]);
+				expected.births += std::popcount(after[i] & ~before[i]);
+				expected.deaths += std::popcount(before[i] & ~after[i]);
+			}
+			check(w >= first && w <= last && result.hash == expected.hash && result.births == expected.births && result.deaths == expected.deaths,
+			      std::format("{} compare kernel from word {}", isa.name, first));
+		}
+		// dying cells of every number of planes against fade_word()
+		for (const uint32_t states : {3u, 4u, 5u, 9u})
+		{
+			const uint32_t planes {static_cast<uint32_t>(std::bit_width(states - 2))};
+			const uint32_t size {53};
+			std::vector<uint64_t> words[2][1 + game::decay::max_planes];
+			for (auto & copy : words)
+			{
+				for (auto & plane : copy)
+				{
+					plane.resize(size);
+				}
+			}
+			for (uint32_t p {}; p <= planes; ++p)
+			{
+				for (uint32_t w {}; w < size; ++w)
+				{
+					words[0][p][w] = words[1][p][w] = random();
+				}
+			}
+			std::vector<uint64_t> previous(size);
+			for (uint64_t & word : previous)
+			{
+				word = random();
+			}
+			game::dying_row rows[2] {};
+			uint64_t hashes[2] {};
+			for (uint32_t c {}; c < 2; ++c)
+			{
+				rows[c].before = previous.data();
+				rows[c].after = words[c][0].data();
+				for (uint32_t p {}; p < planes; ++p)
+				{
+					rows[c].planes[p] = words[c][p + 1].data();
+				}
+				rows[c].count = planes;
+				rows[c].expiry = (states - 1) & ((1u << planes) - 1);
+				rows[c].index = 200;
+				rows[c].size = 4000;
+			}
+			const uint32_t w {isa.decay(planes)(rows[0], 2, size, hashes[0])};
+			for (uint32_t i {2}; i < w; ++i)
+			{
+				switch (planes)
+				{
+					case 1: game::fade_word<1>(rows[1], i, hashes[1]); break;
+					case 2: game::fade_word<2>(rows[1], i, hashes[1]); break;
+					default: game::fade_word<3>(rows[1], i, hashes[1]); break;
+				}
+			}
+			bool same {w >= 2 && w <= size && hashes[0] == hashes[1]};
+			for (uint32_t p {}; same && p <= planes; ++p)
+			{
+				same = words[0][p] == words[1][p];
+			}
+			check(same, std::format("{} decay kernel of {} states", isa.name, states));
+		}
+	}
+	
+	// unbounded engines against the torus, with a margin the soup can not cross in the generations played
+	void test_engines()
+	{
+		const uint32_t soup {20};
+		const uint32_t margin {48};
+		const uint32_t generations {32};
+		uint64_t seed {2000};
+		for (const game::rule & r : {game::conway, game::highlife, named("B36/S125")})
+		{
+			const cells start {random_cells(soup, soup, 2, ++seed, 40)};
+			cells expected {soup + 2 * margin, soup + 2 * margin, std::vector<uint8_t>(static_cast<std::size_t>(soup + 2 * margin) * (soup + 2 * margin))};
+			for (uint32_t y {}; y < soup; ++y)
+			{
+				for (uint32_t x {}; x < soup; ++x)
+				{
+					expected.at(margin + x, margin + y) = start.at(x, y);
+				}
+			}
+			for (uint32_t g {}; g < generations; ++g)
+			{
+				expected = reference_step(expected, r);
+			}
+			const game::grid torus {living(expected)};
+			std::vector<std::pair<std::string, std::unique_ptr<game::universe>>> engines;
+			engines.emplace_back("hashlife --step 0", std::make_unique<game::hashlife>(0, uint64_t {64} << 20));
+			engines.emplace_back("hashlife --step 3", std::make_unique<game::hashlife>(3, uint64_t {64} << 20));
+			engines.emplace_back("sparse", std::make_unique<game::sparse>());
+			for (auto & [name, engine] : engines)
+			{
+				engine->clear(r);
+				for (uint32_t y {}; y < soup; ++y)
+				{
+					for (uint32_t x {}; x < soup; ++x)
+					{
+						if (start.at(x, y) == 1)
+						{
+							engine->set(margin + x, margin + y);
+						}
+					}
+				}
+				uint64_t played {};
+				while (played < generations)
+				{
+					engine->advance();
+					played += engine->step();
+				}
+				game::grid window {torus.width(), torus.height()};
+				engine->read(window, 0, 0);
+				check(played == generations && window == torus, std::format("{} plays {}", name, game::rule_name(r)));
+				check(engine->population() == torus.population(), std::format("{} counts the population of {}", name, game::rule_name(r)));
+			}
+		}
+	}
+	
+	void test_rle()
+	{
+		uint64_t seed {3000};
+		for (const game::rule & r : rules())
+		{
+			for (const auto & [width, height] : std::initializer_list<std::pair<uint32_t, uint32_t>> {{1, 1}, {5, 3}, {70, 9}, {200, 64}})
+			{
+				const std::string name {std::format("{} {}x{}", game::rule_name(r), width, height)};
+				game::pattern written;
+				write_cells(random_cells(width, height, r.states, ++seed, 30), written.cells, written.dying, r.states);
+				std::ostringstream out;
+				game::write_rle(out, written.cells, written.dying, game::rule_name(r));
+				const std::string text {out.str()};
+				game::pattern read;
+				uint32_t x {};
+				uint32_t y {};
+				uint64_t line {};
+				game::pool workers {1};
+				check(game::read_pattern(text, read, x, y, line, workers) == game::parsed::OK, std::format("RLE of {} is read", name));
+				check(read.cells == written.cells && read.dying == written.dying && read.rule == game::rule_name(r),
+				      std::format("RLE of {} reads back as written", name));
+				// any cut of the file is read or refused, never past the world
+				for (std::size_t size {}; size < text.size(); ++size)
+				{
+					std::istringstream in {text.substr(0, size)};
+					game::read_rle(in, read, x, y, line);
+				}
+			}
+		}
+	}
+	
+	void test_coordinates()
+	{
+		uint64_t seed {4000};
+		// the large file is split between the workers
+		for (const auto & [width, height] : std::initializer_list<std::pair<uint32_t, uint32_t>> {{1, 1}, {7, 5}, {300, 100}, {1000, 1000}})
+		{
+			const game::grid world {living(random_cells(width, height, 2, ++seed, 15))};
+			std::string text {std::format("{} {}\n", height, width)};
+			for (uint32_t y {}; y < height; ++y)
+			{
+				for (uint32_t x {}; x < width; ++x)
+				{
+					if (world.get(x, y))
+					{
+						text += std::format("{} {}\n", y, x);
+					}
+				}
+			}
+			for (const uint32_t count : {1u, 4u})
+			{
+				game::pool workers {count};
+				game::pattern read;
+				uint32_t x {};
+				uint32_t y {};
+				uint64_t line {};
+				check(game::read_pattern(text, read, x, y, line, workers) == game::parsed::OK && read.cells == world,
+				      std::format("coordinates of {}x{} read back by {} workers", width, height, count));
+			}
+		}
+	}
+	
+	// same as in snapshot.cpp, so broken headers can be made that pass it
+	uint64_t checksum(const std::string_view data)
+	{
+		uint64_t h {0x9e3779b97f4a7c15};
+		std::size_t i {};
+		for (; i + 8 <= data.size(); i += 8)
+		{
+			uint64_t word {};
+			for (std::size_t b {}; b < 8; ++b)
+			{
+				word |= uint64_t {static_cast<uint8_t>(data[i + b])} << (b * 8);
+			}
+			h = (h ^ word) * 0xff51afd7ed558ccd;
+			h ^= h >> 29;
+		}
+		for (; i < data.size(); ++i)
+		{
+			h = (h ^ static_cast<uint8_t>(data[i])) * 0xff51afd7ed558ccd;
+			h ^= h >> 29;
+		}
+		return h;
+	}
+	
+	void put(std::string & data, std::size_t offset, uint64_t value, std::size_t bytes)
+	{
+		for (std::size_t i {}; i < bytes; ++i)
+		{
+			data[offset + i] = static_cast<char>(value >> (i * 8));
+		}
+	}
+	
+	void test_snapshots()
+	{
+		uint64_t seed {5000};
+		for (const game::rule & r : rules())
+		{
+			for (const auto & [width, height] : std::initializer_list<std::pair<uint32_t, uint32_t>> {{1, 1}, {65, 3}, {300, 130}})
+			{
+				const std::string name {std::format("{} {}x{}", game::rule_name(r), width, height)};
+				game::snapshot written {game::grid {}, 1234567890123, game::rule_name(r), game::decay {}};
+				write_cells(random_cells(width, height, r.states, ++seed, 20), written.cells, written.dying, r.states);
+				std::string data;
+				game::write_snapshot(data, written);
+				game::snapshot read {};
+				check(game::is_snapshot(data) && game::read_snapshot(data, read) == game::parsed::OK, std::format("snapshot of {} is read", name));
+				check(read.cells == written.cells && read.dying == written.dying && read.generation == written.generation && read.rule == written.rule,
+				      std::format("snapshot of {} reads back as written", name));
+				for (std::size_t size {}; size < data.size(); ++size)
+				{
+					check(game::read_snapshot(std::string_view {data}.substr(0, size), read) != game::parsed::OK,
+					      std::format("snapshot of {} cut to {} bytes is refused", name, size));
+				}
+			}
+		}
+		// sizes that are out of bounds, in files with a good checksum
+		game::snapshot small {game::grid {3, 3}, 0, "B3/S23", game::decay {}};
+		small.dying.resize(3, 3, 2);
+		std::string data;
+		game::write_snapshot(data, small);
+		for (const auto & [width, height] : std::initializer_list<std::pair<uint32_t, uint32_t>> {{0, 3}, {3, 0}, {0xffffffff, 0xffffffff},
+		                                                                                             {game::max_side + 1, 1}, {game::max_side, game::max_side}})
+		{
+			std::string forged {data};
+			put(forged, 12, width, 4);
+			put(forged, 16, height, 4);
+			put(forged, forged.size() - 8, checksum(std::string_view {forged}.substr(0, forged.size() - 8)), 8);
+			game::snapshot read {};
+			check(game::read_snapshot(forged, read) == game::parsed::UNREADABLE, std::format("snapshot of {}x{} is refused", width, height));
+		}
+	}
+	
+	// files that once crashed the readers or made them allocate without bounds
+	void test_broken_files()
+	{
+		const std::initializer_list<std::pair<std::string_view, game::parsed>> files {
+			{"x = 4294967295, y = 4294967295\no!\n", game::parsed::UNREADABLE},
+			{"x = 2000000, y = 2000000\no!\n", game::parsed::UNREADABLE},
+			{"x = 0, y = 5\no!\n", game::parsed::UNREADABLE},
+			{"x = 5\no!\n", game::parsed::UNREADABLE},
+			{"x = 3, y = 3\n4o!\n", game::parsed::OUT_OF_RANGE},
+			{"x = 3, y = 3\n2b2o!\n", game::parsed::OUT_OF_RANGE},
+			{"x = 3, y = 3\n4294967297o!\n", game::parsed::UNREADABLE},
+			{"x = 3, y = 3\n3$o!\n", game::parsed::OUT_OF_RANGE},
+			{"x = 3, y = 3\n4294967295$o!\n", game::parsed::UNREADABLE},
+			{"x = 3, y = 3\n99999999$o!\n", game::parsed::OUT_OF_RANGE},
+			{"x = 3, y = 3, rule = B2/S/C3\n4B!\n", game::parsed::OUT_OF_RANGE},
+			{"x = 3, y = 3\nz!\n", game::parsed::UNREADABLE},
+			{"x = 3, y = 3\nA!\n", game::parsed::UNREADABLE},
+			{"x = 3, y = 3, rule = B0/S\no!\n", game::parsed::UNSUPPORTED_RULE},
+			{"4294967295 4294967295\n0 0\n", game::parsed::UNREADABLE},
+			{"2000000 2000000\n0 0\n", game::parsed::UNREADABLE},
+			{"0 0\n", game::parsed::UNREADABLE},
+			{"0 5\n", game::parsed::UNREADABLE},
+			{"5 0\n", game::parsed::UNREADABLE},
+			{"3 3\n3 0\n", game::parsed::OUT_OF_RANGE},
+			{"3 3\n0 4294967295\n", game::parsed::OUT_OF_RANGE},
+			{"3 3\n0 x\n", game::parsed::UNREADABLE}};
+		game::pool workers {1};
+		for (const auto & [text, expected] : files)
+		{
+			game::pattern p;
+			uint32_t x {};
+			uint32_t y {};
+			uint64_t line {};
+			std::string shown {text};
+			for (std::size_t end {shown.find('\n')}; end != std::string::npos; end = shown.find('\n', end))
+			{
+				shown.replace(end, 1, "\\n");
+			}
+			check(game::read_pattern(text, p, x, y, line, workers) == expected, std::format("reading \"{}\"", shown));
+		}
+	}
+}
+
+int main()
+{
+	test_kernel();
+	for (const vector_isa & isa : vector_isas())
+	{
+		test_vectors(isa);
+	}
+	test_engines();
+	test_rle();
+	test_coordinates();
+	test_snapshots();
+	test_broken_files();
+	fputs(std::format("kernel {}, {} failed checks\n", game::step_isa(), failures).c_str(), stdout);
+	return failures == 0 ? 0 : 1;
+}
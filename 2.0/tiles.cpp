@@ -0,0 +1,129 @@
+//
+//  tiles.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "tiles.h"
+#include "kernel.h"
+#include <algorithm>
+
+namespace game
+{
+	tiles::tiles() : m_columns(), m_rows(), m_history()
+	{
+		
+	}
+	
+	void tiles::resize(uint32_t width, uint32_t height, uint32_t history)
+	{
+		m_columns = (width + size - 1) / size;
+		m_rows = (height + size - 1) / size;
+		m_history = history;
+		m_changed.resize(static_cast<std::size_t>(m_columns) * m_rows);
+		m_changing.resize(m_changed.size());
+		m_quiet.resize(m_changed.size());
+		m_actions.resize(m_changed.size());
+		m_column.resize(m_changed.size());
+		m_spans.resize(m_changed.size());
+		reset();
+	}
+	
+	void tiles::reset()
+	{
+		std::fill(m_changed.begin(), m_changed.end(), 1);
+		std::fill(m_quiet.begin(), m_quiet.end(), 0);
+	}
+	
+	uint32_t tiles::rows() const
+	{
+		return m_rows;
+	}
+	
+	changes tiles::step(const kernel & rule, const grid & src, grid & dst, uint32_t first, uint32_t last)
+	{
+		changes result {};
+		for (uint32_t ty {first}; ty < last; ++ty)
+		{
+			action * actions {m_actions.data() + static_cast<std::size_t>(ty) * m_columns};
+			uint8_t * quiet {m_quiet.data() + static_cast<std::size_t>(ty) * m_columns};
+			uint8_t * changing {m_changing.data() + static_cast<std::size_t>(ty) * m_columns};
+			uint8_t * column {m_column.data() + static_cast<std::size_t>(ty) * m_columns};
+			span * spans {m_spans.data() + static_cast<std::size_t>(ty) * m_columns};
+			// world being written is m_history - 1 generations older than src,
+			// it already holds the tile once the tile has been quiet that long
+			// a tile is active if anything in the 3x3 tiles around it changed, columns are merged first
+			const uint8_t * above {m_changed.data() + static_cast<std::size_t>((ty + m_rows - 1) % m_rows) * m_columns};
+			const uint8_t * level {m_changed.data() + static_cast<std::size_t>(ty) * m_columns};
+			const uint8_t * below {m_changed.data() + static_cast<std::size_t>((ty + 1) % m_rows) * m_columns};
+			for (uint32_t tx {}; tx < m_columns; ++tx)
+			{
+				column[tx] = above[tx] | level[tx] | below[tx];
+			}
+			for (uint32_t tx {}; tx < m_columns; ++tx)
+			{
+				if (column[(tx + m_columns - 1) % m_columns] | column[tx] | column[(tx + 1) % m_columns])
+				{
+					actions[tx] = action::STEP;
+				}
+				else
+				{
+					actions[tx] = quiet[tx] + 1u < m_history ? action::COPY : action::SKIP;
+				}
+			}
+			// consecutive tiles with the same action are handled as one span,
+			// so the kernel can use vectors over them and skipped tiles cost nothing per row
+			uint32_t count {};
+			for (uint32_t tx {}; tx < m_columns; )
+			{
+				uint32_t end {tx + 1};
+				while (end < m_columns && actions[end] == actions[tx])
+				{
+					++end;
+				}
+				if (actions[tx] != action::SKIP)
+				{
+					spans[count++] = {tx, end, actions[tx]};
+				}
+				tx = end;
+			}
+			const uint32_t y_last {std::min((ty + 1) * size, src.height())};
+			for (uint32_t y {ty * size}; y < y_last; ++y)
+			{
+				for (uint32_t i {}; i < count; ++i)
+				{
+					const span & s {spans[i]};
+					if (s.what == action::STEP)
+					{
+						rule.step_span(src, dst, y, s.first, s.last);
+						result += compare(src, dst, y, s.first, s.last);
+					}
+					else
+					{
+						std::copy(src.row(y) + s.first, src.row(y) + s.last, dst.row(y) + s.first);
+					}
+				}
+			}
+			for (uint32_t tx {}; tx < m_columns; ++tx)
+			{
+				uint64_t difference {};
+				if (actions[tx] == action::STEP)
+				{
+					for (uint32_t y {ty * size}; y < y_last; ++y)
+					{
+						difference |= src.row(y)[tx] ^ dst.row(y)[tx];
+					}
+				}
+				changing[tx] = difference != 0;
+				quiet[tx] = difference ? 0 : static_cast<uint8_t>(std::min<uint32_t>(quiet[tx] + 1u, m_history));
+			}
+		}
+		return result;
+	}
+	
+	void tiles::swap()
+	{
+		m_changed.swap(m_changing);
+	}
+}
@@ -0,0 +1,61 @@
+//
+//  tiles.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include "kernel.h"
+#include <vector>
+#include <cstdint>
+
+namespace game
+{
+	// change tracker of the torus: the world is cut into tiles one word (64 cells) wide and 64 rows high,
+	// only tiles that changed in the last generation or have a changed neighbour are stepped,
+	// so the cost of a generation follows the activity instead of the size of the world
+	class tiles
+	{
+	public:
+		static constexpr uint32_t size {64};
+		tiles();
+		// history is the number of worlds in the ring, so the world written by a step is history - 1 generations
+		// older than the one it is stepped from
+		void resize(uint32_t width, uint32_t height, uint32_t history);
+		// every tile is treated as changed, used whenever the world is written from outside
+		void reset();
+		uint32_t rows() const;
+		// steps tile rows [first, last) of src into dst by the rule of the kernel, tile rows of different calls can run in parallel;
+		// returns what changed in these rows: the hash to be XORed with the one of src, births and deaths
+		changes step(const kernel & rule, const grid & src, grid & dst, uint32_t first, uint32_t last);
+		// makes changes of the finished generation visible to the next one
+		void swap();
+	private:
+		enum class action : uint8_t
+		{
+			STEP,													// tile or its neighbour changed
+			COPY,													// quiet tile, but the old world behind it is out of date
+			SKIP													// quiet long enough that the old world already holds it
+		};
+		// consecutive tiles of a tile row with the same action
+		struct span
+		{
+			uint32_t first;
+			uint32_t last;
+			action what;
+		};
+	private:
+		uint32_t m_columns;
+		uint32_t m_rows;
+		uint32_t m_history;
+		std::vector<uint8_t> m_changed;								// tiles changed in the last generation
+		std::vector<uint8_t> m_changing;							// tiles changing in the generation being stepped
+		std::vector<uint8_t> m_quiet;								// generations in a row without change, up to the history
+		std::vector<action> m_actions;
+		// scratch of step(), a tile row of each for every tile row, so steps of different rows share nothing
+		std::vector<uint8_t> m_column;								// changes of the tile and the ones above and below it
+		std::vector<span> m_spans;
+	};
+}
@@ -0,0 +1,173 @@
+//
+//  timings.cpp
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#include "timings.h"
+#include <bit>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+namespace game
+{
+	std::string_view phase_name(phase p)
+	{
+		switch (p)
+		{
+			case phase::STEP:
+			{
+				return "step";
+			}
+			case phase::HISTORY:
+			{
+				return "history";
+			}
+			case phase::CYCLE:
+			{
+				return "cycle";
+			}
+			case phase::PUBLISH:
+			{
+				return "publish";
+			}
+			case phase::FRAME:
+			{
+				return "frame";
+			}
+			default:
+			{
+				return "write";
+			}
+		}
+	}
+	
+	std::chrono::steady_clock::time_point timings::add(phase p, std::chrono::steady_clock::time_point start)
+	{
+		const auto now {std::chrono::steady_clock::now()};
+		const uint64_t time {static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count())};
+		histogram & h {m_phases[static_cast<std::size_t>(p)]};
+		// the phase has a single writer, so plain loads and stores do without locked instructions
+		std::atomic<uint64_t> & count {h.counts[bucket(time)]};
+		count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		h.total.store(h.total.load(std::memory_order_relaxed) + time, std::memory_order_relaxed);
+		if (time > h.longest.load(std::memory_order_relaxed))
+		{
+			h.longest.store(time, std::memory_order_relaxed);
+		}
+		return now;
+	}
+	
+	timings::counts timings::read(phase p) const
+	{
+		const histogram & h {m_phases[static_cast<std::size_t>(p)]};
+		counts c {};
+		for (uint32_t i {}; i < buckets; ++i)
+		{
+			c[i] = h.counts[i].load(std::memory_order_relaxed);
+		}
+		return c;
+	}
+	
+	std::chrono::nanoseconds timings::percentile(const counts & c, double fraction)
+	{
+		uint64_t total {};
+		for (const uint64_t n : c)
+		{
+			total += n;
+		}
+		// rank of the duration looked for among the sorted ones, from 1
+		const uint64_t rank {std::max(static_cast<uint64_t>(std::ceil(fraction * total)), uint64_t {1})};
+		uint64_t seen {};
+		for (uint32_t i {}; i < buckets; ++i)
+		{
+			seen += c[i];
+			if (seen >= rank)
+			{
+				return std::chrono::nanoseconds {bound(i)};
+			}
+		}
+		return {};
+	}
+	
+	// below 8 ns every duration has a bucket of its own, above a power of two is split in 4
+	uint32_t timings::bucket(uint64_t nanoseconds)
+	{
+		if (nanoseconds < 8)
+		{
+			return static_cast<uint32_t>(nanoseconds);
+		}
+		const uint32_t exponent {static_cast<uint32_t>(std::bit_width(nanoseconds)) - 1};
+		return 8 + (exponent - 3) * 4 + static_cast<uint32_t>((nanoseconds >> (exponent - 2)) & 3);
+	}
+	
+	uint64_t timings::bound(uint32_t index)
+	{
+		if (index < 8)
+		{
+			return index;
+		}
+		const uint32_t exponent {(index - 8) / 4 + 3};
+		const uint64_t quarter {uint64_t {1} << (exponent - 2)};
+		return (4 + (index - 8) % 4) * quarter + quarter - 1;
+	}
+	
+	bool timings::write(const std::string & filename, report format) const
+	{
+		std::string text;
+		auto out {std::back_inserter(text)};
+		if (format == report::CSV)
+		{
+			std::format_to(out, "phase,count,mean_ns,p50_ns,p90_ns,p99_ns,max_ns\n");
+		}
+		else
+		{
+			std::format_to(out, "{{\"phases\": [");
+		}
+		for (uint32_t p {}; p < m_phases.size(); ++p)
+		{
+			const histogram & h {m_phases[p]};
+			const counts c {read(static_cast<phase>(p))};
+			uint64_t count {};
+			for (const uint64_t n : c)
+			{
+				count += n;
+			}
+			const uint64_t total {h.total.load(std::memory_order_relaxed)};
+			const uint64_t mean {count == 0 ? 0 : total / count};
+			const std::string_view name {phase_name(static_cast<phase>(p))};
+			if (format == report::CSV)
+			{
+				std::format_to(out, "{},{},{},{},{},{},{}\n", name, count, mean, percentile(c, 0.5).count(),
+				               percentile(c, 0.9).count(), percentile(c, 0.99).count(), h.longest.load(std::memory_order_relaxed));
+				continue;
+			}
+			std::format_to(out, "{}{{\"phase\": \"{}\", \"count\": {}, \"mean_ns\": {}, \"p50_ns\": {}, \"p90_ns\": {}, \"p99_ns\": {}, "
+			               "\"max_ns\": {}, \"buckets\": {{", p == 0 ? "" : ", ", name, count, mean, percentile(c, 0.5).count(),
+			               percentile(c, 0.9).count(), percentile(c, 0.99).count(), h.longest.load(std::memory_order_relaxed));
+			// nonzero buckets by the longest duration in them
+			bool first {true};
+			for (uint32_t i {}; i < buckets; ++i)
+			{
+				if (c[i] != 0)
+				{
+					std::format_to(out, "{}\"{}\": {}", first ? "" : ", ", bound(i), c[i]);
+					first = false;
+				}
+			}
+			std::format_to(out, "}}}}");
+		}
+		if (format == report::JSON)
+		{
+			std::format_to(out, "]}}\n");
+		}
+		std::ofstream fout {filename, std::ios_base::out};
+		fout.write(text.data(), static_cast<std::streamsize>(text.size()));
+		fout.close();
+		return static_cast<bool>(fout);
+	}
+}
@@ -0,0 +1,62 @@
+//
+//  timings.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "settings.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+namespace game
+{
+	// parts of a generation and of a frame timed on their own
+	enum class phase : uint32_t
+	{
+		STEP,														// next generation by the engine
+		HISTORY,													// hash of the generation kept with the earlier ones
+		CYCLE,														// end states looked for, worlds compared when a hash repeats
+		PUBLISH,													// generation copied for the render thread
+		FRAME,														// board and status line composed into a frame
+		WRITE,														// frame written to the terminal
+		COUNT
+	};
+	
+	std::string_view phase_name(phase p);
+	
+	// durations of every phase counted in buckets a quarter of a power of two wide, so recording one takes a few
+	// instructions without locks and percentiles are read to within 25%; every phase is recorded by one thread
+	// at a time, any thread may read the counts meanwhile
+	class timings
+	{
+	public:
+		static constexpr uint32_t buckets {256};
+		using counts = std::array<uint64_t, buckets>;
+		// counts the time from start till now for the phase and returns now, where the next phase starts
+		std::chrono::steady_clock::time_point add(phase p, std::chrono::steady_clock::time_point start);
+		counts read(phase p) const;
+		// time the given fraction of the counted durations does not exceed, zero if none are counted
+		static std::chrono::nanoseconds percentile(const counts & c, double fraction);
+		// count, mean, percentiles and longest time of every phase, in JSON also the buckets; false if writing failed
+		bool write(const std::string & filename, report format) const;
+	private:
+		static uint32_t bucket(uint64_t nanoseconds);
+		// longest duration counted in the bucket
+		static uint64_t bound(uint32_t index);
+	private:
+		// phases measured by different threads are on cache lines of their own
+		struct alignas(64) histogram
+		{
+			std::array<std::atomic<uint64_t>, buckets> counts;
+			std::atomic<uint64_t> total;							// nanoseconds
+			std::atomic<uint64_t> longest;
+		};
+		std::array<histogram, static_cast<std::size_t>(phase::COUNT)> m_phases;
+	};
+}
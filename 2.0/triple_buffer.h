@@ -0,0 +1,63 @@
+//
+//  triple_buffer.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace game
+{
+	// lock-free handoff of values from one writer thread to one reader thread:
+	// the writer fills the back buffer and swaps it with the middle one, the reader swaps its front buffer
+	// with the middle one whenever something new is there, so neither of them ever waits for the other
+	// and the reader always gets the latest value, skipping the ones it had no time for
+	template <typename T>
+	class triple_buffer
+	{
+	public:
+		triple_buffer() : m_back(0), m_middle(1), m_front(2)
+		{
+			
+		}
+		
+		T & back()
+		{
+			return m_buffers[m_back];
+		}
+		
+		// hands the back buffer to the reader, the writer continues with the previous middle one
+		void publish()
+		{
+			m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) & index;
+		}
+		
+		// takes the latest published buffer, returns false if nothing was published since the last call
+		bool fetch()
+		{
+			if ((m_middle.load(std::memory_order_relaxed) & fresh) == 0)
+			{
+				return false;
+			}
+			m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index;
+			return true;
+		}
+		
+		const T & front() const
+		{
+			return m_buffers[m_front];
+		}
+	private:
+		static constexpr uint32_t index {3};
+		static constexpr uint32_t fresh {4};						// middle buffer holds a value the reader has not taken yet
+	private:
+		std::array<T, 3> m_buffers;
+		uint32_t m_back;
+		std::atomic<uint32_t> m_middle;
+		uint32_t m_front;
+	};
+}
@@ -0,0 +1,29 @@
+//
+//  universe.h
+//  John Conway's Game of Life
+//
+//  Created by Denis Fedorov on 14.01.2023.
+//
+
+#pragma once
+#include "grid.h"
+#include "rule.h"
+#include <cstdint>
+
+namespace game
+{
+	// engine of an unbounded plane as opposed to the torus stepped by game::kernel,
+	// life shows a window of it the size of the loaded pattern
+	class universe
+	{
+	public:
+		virtual ~universe() = default;
+		virtual void clear(const rule & r) = 0;						// empties the plane, the next generations are played by the rule
+		virtual void set(int64_t x, int64_t y) = 0;					// makes cell at X and Y alive
+		virtual void advance() = 0;									// moves step() generations forward
+		virtual uint64_t step() const = 0;
+		virtual uint64_t population() const = 0;
+		// copies cells of the plane starting at left and top into the window, the size of the window is kept
+		virtual void read(grid & window, int64_t left, int64_t top) const = 0;
+	};
+}